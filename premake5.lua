@@ -9,6 +9,21 @@ project "SilentPatchTOCA2"
 	include "source/VersionInfo.lua"
 	files { "**/MemoryMgr.h", "**/Patterns.*", "**/HookInit.hpp" }
 
+project "StatsReader"
+	kind "ConsoleApp"
+	language "C++"
+
+	files { "tools/StatsReader/*.cpp", "source/LiveStats.h" }
+	removefiles { "source/*.cpp", "source/resources/*.rc" }
+
+project "Tests"
+	kind "ConsoleApp"
+	language "C++"
+
+	includedirs { "source" }
+	files { "tests/*.h", "tests/*.cpp" }
+	removefiles { "source/SilentPatchTOCA2.cpp", "source/HookInit.cpp", "source/resources/*.rc" }
+
 
 workspace "*"
 	configurations { "Debug", "Release", "Master" }
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Live statistics page, published in a named shared memory section
+// so the game can be monitored from another process. Also included by the stats reader.
+namespace LiveStats
+{
+	static constexpr uint32_t PAGE_MAGIC = 0x32544F54; // TOT2
+	static constexpr uint32_t PAGE_VERSION = 7;
+
+	enum class SurfaceCategory
+	{
+		Framebuffer,
+		DepthBuffer,
+		RenderTarget,
+		Texture,
+		Other,
+
+		NumCategories
+	};
+
+	struct SurfaceMemory
+	{
+		uint32_t videoMemoryBytes;
+		uint32_t systemMemoryBytes;
+		uint32_t bytesPerCategory[static_cast<size_t>(SurfaceCategory::NumCategories)];
+		uint32_t surfacesPerCategory[static_cast<size_t>(SurfaceCategory::NumCategories)];
+		uint32_t mirrorSurfaceSize; // As stored in the game's D3D resources table
+	};
+
+	static constexpr size_t MAX_FORMATS_PER_CATEGORY = 4;
+
+	struct SurfaceFormat
+	{
+		uint32_t fourCC; // 0 for RGB and depth formats
+		uint32_t bitCount;
+		uint32_t numSurfaces;
+	};
+
+	// Formats of the surfaces of one category, in the order they were first seen
+	struct SurfaceFormats
+	{
+		SurfaceFormat formats[MAX_FORMATS_PER_CATEGORY];
+		uint32_t numUnlistedSurfaces; // Surfaces in formats past the first MAX_FORMATS_PER_CATEGORY ones
+	};
+
+	inline void AddSurfaceFormat(SurfaceFormats& formats, uint32_t fourCC, uint32_t bitCount)
+	{
+		for (SurfaceFormat& format : formats.formats)
+		{
+			if (format.numSurfaces == 0)
+			{
+				format.fourCC = fourCC;
+				format.bitCount = bitCount;
+			}
+			if (format.fourCC == fourCC && format.bitCount == bitCount)
+			{
+				format.numSurfaces++;
+				return;
+			}
+		}
+		formats.numUnlistedSurfaces++;
+	}
+
+	// Power of two size classes, from 16 bytes - the last class also holds everything larger
+	static constexpr uint32_t ALLOC_SMALLEST_SIZE_CLASS = 16;
+	static constexpr size_t NUM_ALLOC_SIZE_CLASSES = 16;
+
+	struct AllocHistogram
+	{
+		uint32_t numAllocations;
+		uint32_t allocationTimeMicroseconds;
+		uint32_t sizeClassCounts[NUM_ALLOC_SIZE_CLASSES];
+	};
+
+	// Since the game window was last restored
+	struct RestoreAllocations
+	{
+		uint32_t numRestores;
+		uint32_t allocations;
+		uint32_t allocationTimeMicroseconds;
+	};
+
+	// Of the last race load
+	struct LoadTimes
+	{
+		uint32_t skinsLoadMicroseconds;
+		uint32_t decalsLoadMicroseconds;
+		uint32_t prefetched; // Number of files read ahead of the load
+		uint32_t prefetchedBytes;
+		uint32_t prefetchMicroseconds;
+	};
+
+	// Of the last complete frame - frame time minus the time spent in Flip tells CPU bound frames apart from present bound ones
+	struct DirectDrawFrameStats
+	{
+		uint32_t numCreateSurface;
+		uint32_t numCreatePalette;
+		uint32_t numLock;
+		uint32_t numUnlock;
+		uint32_t numBlt;
+		uint32_t numFlip;
+		uint32_t flipMicroseconds; // Time spent inside Flip
+		uint32_t flipIntervalMicroseconds; // Between the two most recent Flips
+	};
+
+	// Append only - readers check the version and the size to know which fields they can read
+	struct Data
+	{
+		float fps;
+		float frameTime; // In milliseconds
+
+		uint32_t allocListCapacity;
+		uint32_t allocListLiveCount;
+		uint32_t numPalettes;
+		uint32_t numResolutions;
+		uint32_t currentResWidth, currentResHeight;
+		int32_t currentCamera;
+		uint32_t configEpoch;
+
+		// Version 2
+		SurfaceMemory surfaceMemory; // Updated on race load and on restore
+
+		// Version 3
+		AllocHistogram allocHistogram; // Of the game allocations tracked in the allocation list, only filled with AllocStats=1
+
+		// Version 4
+		LoadTimes loadTimes;
+
+		// Version 5
+		DirectDrawFrameStats directDrawFrame; // Only filled with DirectDrawStats=1
+
+		// Version 6
+		RestoreAllocations restoreAllocations; // Only filled with AllocStats=1
+
+		// Version 7
+		SurfaceFormats surfaceFormats[static_cast<size_t>(SurfaceCategory::NumCategories)]; // Updated along with surfaceMemory
+	};
+
+	struct Page
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t dataSize;
+		std::atomic<uint32_t> sequence; // Odd while the data is being written
+		Data data;
+	};
+	static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+	inline void InitializePage(Page* page)
+	{
+		page->magic = PAGE_MAGIC;
+		page->version = PAGE_VERSION;
+		page->dataSize = sizeof(page->data);
+		page->sequence.store(0, std::memory_order_relaxed);
+		std::memset(&page->data, 0, sizeof(page->data));
+	}
+
+	// Single writer only, never waits on the readers
+	inline void Write(Page* page, const Data& data)
+	{
+		const uint32_t seq = page->sequence.load(std::memory_order_relaxed);
+		page->sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		std::memcpy(&page->data, &data, sizeof(data));
+
+		page->sequence.store(seq + 2, std::memory_order_release);
+	}
+
+	// Returns false if the writer was in the middle of an update, the caller should retry.
+	// Pages written by an older version are shorter - the fields they don't have read as zeroes
+	inline bool TryRead(const Page* page, Data& data)
+	{
+		const uint32_t seqBefore = page->sequence.load(std::memory_order_acquire);
+		if ((seqBefore & 1) != 0)
+		{
+			return false;
+		}
+
+		const size_t size = page->dataSize < sizeof(data) ? page->dataSize : sizeof(data);
+		std::memcpy(&data, &page->data, size);
+		std::memset(reinterpret_cast<uint8_t*>(&data) + size, 0, sizeof(data) - size);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return page->sequence.load(std::memory_order_relaxed) == seqBefore;
+	}
+
+	// Whether the page was written by a version publishing the given field - newer versions only ever append fields,
+	// so a page with a newer version than the reader's can still be read
+	inline bool HasField(const Page* page, uint32_t sinceVersion, size_t fieldOffset, size_t fieldSize)
+	{
+		return page->version >= sinceVersion && page->dataSize >= fieldOffset + fieldSize;
+	}
+
+	// Local\SilentPatchTOCA2_Stats_<process ID>
+	static constexpr wchar_t SECTION_NAME_FORMAT[] = L"Local\\SilentPatchTOCA2_Stats_%u";
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+
+// Keeps the in-car mirror within the frame budget, based on the measured frame times.
+// The cheap step is applied live - the mirror gets re-rendered only every Nth frame.
+// Past that, the resolution is stepped between powers of two in the minRes - maxRes range,
+// but a new resolution only takes effect once the mirror is recreated - until the game reports that
+// via OnResolutionApplied, frame times are ignored, so they are never judged against a size not in use yet.
+class MirrorGovernor
+{
+public:
+	static constexpr uint32_t MAX_UPDATE_INTERVAL = 3;
+
+	void Initialize(uint16_t minRes, uint16_t maxRes, double budgetMS)
+	{
+		m_minRes = minRes;
+		m_maxRes = maxRes;
+		m_resolution = m_appliedResolution = maxRes;
+		m_updateInterval = 1;
+		m_frameCounter = 0;
+		m_budget = budgetMS;
+		m_averageFrameTime = 0.0;
+		m_framesOverBudget = m_framesUnderBudget = 0;
+		m_cooldown = 0;
+	}
+
+	bool IsEnabled() const { return m_budget > 0.0; }
+	uint16_t GetResolution() const { return m_resolution; }
+	uint16_t GetAppliedResolution() const { return m_appliedResolution; }
+	bool IsResolutionPending() const { return m_resolution != m_appliedResolution; }
+	uint32_t GetUpdateInterval() const { return m_updateInterval; }
+	double GetAverageFrameTime() const { return m_averageFrameTime; }
+
+	void OnResolutionApplied(uint16_t resolution)
+	{
+		if (resolution == m_appliedResolution)
+		{
+			return;
+		}
+		m_appliedResolution = resolution;
+		OnStateChanged();
+	}
+
+	// Called once per mirror frame, returns false if the mirror should keep its previous contents
+	bool ShouldRenderFrame()
+	{
+		if (!IsEnabled() || m_updateInterval <= 1)
+		{
+			m_frameCounter = 0;
+			return true;
+		}
+		const bool render = m_frameCounter == 0;
+		m_frameCounter = (m_frameCounter + 1) % m_updateInterval;
+		return render;
+	}
+
+	// Returns true if the update interval or the requested resolution has changed
+	bool AddFrameTime(double frameTimeMS)
+	{
+		if (!IsEnabled() || IsResolutionPending())
+		{
+			return false;
+		}
+
+		if (m_averageFrameTime == 0.0)
+		{
+			m_averageFrameTime = frameTimeMS;
+		}
+		else
+		{
+			m_averageFrameTime += (frameTimeMS - m_averageFrameTime) * SMOOTHING;
+		}
+
+		// Let the average settle after every change before judging it again
+		if (m_cooldown > 0)
+		{
+			m_cooldown--;
+			return false;
+		}
+
+		if (m_averageFrameTime > m_budget)
+		{
+			m_framesOverBudget++;
+			m_framesUnderBudget = 0;
+		}
+		else if (m_averageFrameTime < m_budget * UPGRADE_HEADROOM)
+		{
+			m_framesUnderBudget++;
+			m_framesOverBudget = 0;
+		}
+		else
+		{
+			m_framesOverBudget = m_framesUnderBudget = 0;
+		}
+
+		// Upgrades undo the downgrades in the reverse order
+		if (m_framesOverBudget >= FRAMES_TO_DOWNGRADE)
+		{
+			if (m_updateInterval < MAX_UPDATE_INTERVAL)
+			{
+				m_updateInterval++;
+				OnStateChanged();
+				return true;
+			}
+			if (m_resolution > m_minRes)
+			{
+				m_resolution /= 2;
+				OnStateChanged();
+				return true;
+			}
+		}
+		if (m_framesUnderBudget >= FRAMES_TO_UPGRADE)
+		{
+			if (m_resolution < m_maxRes)
+			{
+				m_resolution *= 2;
+				OnStateChanged();
+				return true;
+			}
+			if (m_updateInterval > 1)
+			{
+				m_updateInterval--;
+				OnStateChanged();
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	void OnStateChanged()
+	{
+		m_framesOverBudget = m_framesUnderBudget = 0;
+		m_cooldown = COOLDOWN_FRAMES;
+	}
+
+	static constexpr double SMOOTHING = 0.1;
+	// Doubling the resolution quadruples the pixel count, so only go up with plenty of headroom
+	static constexpr double UPGRADE_HEADROOM = 0.75;
+	static constexpr uint32_t FRAMES_TO_DOWNGRADE = 30;
+	static constexpr uint32_t FRAMES_TO_UPGRADE = 180;
+	static constexpr uint32_t COOLDOWN_FRAMES = 60;
+
+	uint16_t m_minRes = 64, m_maxRes = 64, m_resolution = 64, m_appliedResolution = 64;
+	uint32_t m_updateInterval = 1, m_frameCounter = 0;
+	double m_budget = 0.0;
+	double m_averageFrameTime = 0.0;
+	uint32_t m_framesOverBudget = 0, m_framesUnderBudget = 0;
+	uint32_t m_cooldown = 0;
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reading files ahead into the OS file cache, and keeping the lists of files to read.
+// File access is left to the functions passed in.
+namespace Prefetch
+{
+	struct FileSystem
+	{
+		void* (*open)(const std::wstring& path); // nullptr if the file can't be opened
+		size_t (*read)(void* file, void* buffer, size_t size); // 0 at the end of the file or on error
+		void (*close)(void* file);
+		std::vector<std::wstring> (*find)(const std::wstring& pattern); // Full paths of the files matching a wildcard
+	};
+
+	// Paths are read one by one on a worker thread, until the queue drains - paths queued while it's busy get picked up too
+	class ReadAheadQueue
+	{
+	public:
+		explicit ReadAheadQueue(const FileSystem& fileSystem)
+			: m_fileSystem(fileSystem)
+		{
+		}
+
+		// Returns true if the caller has to start a worker thread calling RunWorker
+		bool Add(const std::vector<std::wstring>& paths)
+		{
+			if (paths.empty()) return false;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queuedPaths.insert(m_queuedPaths.end(), paths.begin(), paths.end());
+			if (m_workerRunning)
+			{
+				return false;
+			}
+			m_workerRunning = true;
+			return true;
+		}
+
+		void OnWorkerFailedToStart()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queuedPaths.clear();
+			m_workerRunning = false;
+		}
+
+		void RunWorker()
+		{
+			std::vector<std::byte> buffer(256 * 1024);
+			while (true)
+			{
+				std::wstring path;
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (m_queuedPaths.empty())
+					{
+						m_workerRunning = false;
+						return;
+					}
+					path = std::move(m_queuedPaths.front());
+					m_queuedPaths.erase(m_queuedPaths.begin());
+				}
+
+				const auto startTime = std::chrono::steady_clock::now();
+				m_bytes.fetch_add(ReadPath(path, buffer), std::memory_order_relaxed);
+				m_microseconds.fetch_add(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::steady_clock::now() - startTime).count()), std::memory_order_relaxed);
+			}
+		}
+
+		bool IsBusy() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_workerRunning;
+		}
+
+		void ResetStats()
+		{
+			m_files.store(0, std::memory_order_relaxed);
+			m_bytes.store(0, std::memory_order_relaxed);
+			m_microseconds.store(0, std::memory_order_relaxed);
+		}
+
+		uint32_t GetFiles() const { return m_files.load(std::memory_order_relaxed); }
+		uint32_t GetBytes() const { return m_bytes.load(std::memory_order_relaxed); }
+		uint32_t GetMicroseconds() const { return m_microseconds.load(std::memory_order_relaxed); }
+
+	private:
+		uint32_t ReadFile(const std::wstring& path, std::vector<std::byte>& buffer)
+		{
+			void* file = m_fileSystem.open(path);
+			if (file == nullptr) return 0;
+
+			uint32_t totalRead = 0;
+			size_t bytesRead;
+			while ((bytesRead = m_fileSystem.read(file, buffer.data(), buffer.size())) != 0)
+			{
+				totalRead += static_cast<uint32_t>(bytesRead);
+			}
+			m_fileSystem.close(file);
+
+			m_files.fetch_add(1, std::memory_order_relaxed);
+			return totalRead;
+		}
+
+		uint32_t ReadPath(const std::wstring& path, std::vector<std::byte>& buffer)
+		{
+			if (path.find_first_of(L"*?") == std::wstring::npos)
+			{
+				return ReadFile(path, buffer);
+			}
+
+			uint32_t totalBytes = 0;
+			for (const std::wstring& file : m_fileSystem.find(path))
+			{
+				totalBytes += ReadFile(file, buffer);
+			}
+			return totalBytes;
+		}
+
+		const FileSystem m_fileSystem;
+		mutable std::mutex m_mutex;
+		std::vector<std::wstring> m_queuedPaths; // Guarded by m_mutex
+		bool m_workerRunning = false; // Guarded by m_mutex
+
+		std::atomic<uint32_t> m_files { 0 };
+		std::atomic<uint32_t> m_bytes { 0 };
+		std::atomic<uint32_t> m_microseconds { 0 };
+	};
+
+	// A semicolon separated list of paths, {car} gets replaced with the car ID
+	inline std::vector<std::wstring> ExpandPaths(std::wstring_view pathList, uint8_t carID)
+	{
+		std::vector<std::wstring> paths;
+		const std::wstring carIDString = std::to_wstring(carID);
+
+		size_t start = 0;
+		while (start < pathList.size())
+		{
+			size_t end = pathList.find(L';', start);
+			if (end == std::wstring_view::npos) end = pathList.size();
+
+			std::wstring path(pathList.substr(start, end - start));
+			for (size_t pos = path.find(L"{car}"); pos != std::wstring::npos; pos = path.find(L"{car}", pos))
+			{
+				path.replace(pos, 5, carIDString);
+			}
+			if (!path.empty())
+			{
+				paths.push_back(std::move(path));
+			}
+			start = end + 1;
+		}
+		return paths;
+	}
+
+	// Learned files are stored as a '|' separated list
+	inline std::vector<std::wstring> ParseFileList(std::wstring_view list)
+	{
+		std::vector<std::wstring> files;
+		size_t start = 0;
+		while (start < list.size())
+		{
+			size_t end = list.find(L'|', start);
+			if (end == std::wstring_view::npos) end = list.size();
+			if (end != start)
+			{
+				files.emplace_back(list.substr(start, end - start));
+			}
+			start = end + 1;
+		}
+		return files;
+	}
+
+	inline std::wstring JoinFileList(const std::vector<std::wstring>& files)
+	{
+		std::wstring list;
+		for (const std::wstring& file : files)
+		{
+			if (!list.empty()) list.push_back(L'|');
+			list.append(file);
+		}
+		return list;
+	}
+
+	// Files opened repeatedly during a load are only recorded once, up to maxFiles
+	inline void RecordFile(std::vector<std::wstring>& recorded, std::wstring_view path, size_t maxFiles)
+	{
+		if (recorded.size() < maxFiles && std::find(recorded.begin(), recorded.end(), path) == recorded.end())
+		{
+			recorded.emplace_back(path);
+		}
+	}
+
+	// The files of the latest load replace the learned ones, unless nothing was recorded.
+	// Returns true if the learned files have changed and need saving
+	inline bool MergeRecordedFiles(std::vector<std::wstring>& learned, std::vector<std::wstring>& recorded)
+	{
+		const bool changed = !recorded.empty() && recorded != learned;
+		if (changed)
+		{
+			learned = std::move(recorded);
+		}
+		recorded.clear();
+		return changed;
+	}
+}
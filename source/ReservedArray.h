@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// An array growing in place - its whole maximum size is reserved up front and committed a page at a time,
+// so once it's moved away from the initial storage, it never moves or gets copied again.
+// Reserving and committing memory is left to the functions passed in.
+template<typename T>
+class ReservedArray
+{
+public:
+	using ReserveFunc = void* (*)(size_t size);
+	using CommitFunc = bool (*)(void* address, size_t size);
+
+	enum class GrowResult
+	{
+		Grown,
+		Moved, // First growth, the contents were copied out of the initial storage
+		AtMaxCapacity,
+		Failed,
+	};
+
+	void Initialize(ReserveFunc reserve, CommitFunc commit, size_t pageSize, size_t maxCapacity, T* initialData, size_t initialCapacity)
+	{
+		m_reserve = reserve;
+		m_commit = commit;
+		m_pageSize = pageSize;
+		m_maxCapacity = maxCapacity;
+		m_reserved = nullptr;
+		m_data = initialData;
+		m_capacity = initialCapacity;
+	}
+
+	T* GetData() const { return m_data; }
+	size_t GetCapacity() const { return m_capacity; }
+	size_t GetMaxCapacity() const { return m_maxCapacity; }
+
+	// Adds a page worth of entries - new entries are zeroed
+	GrowResult Grow()
+	{
+		const size_t newCapacity = m_capacity + std::max<size_t>(1, m_pageSize / sizeof(T));
+		if (newCapacity > m_maxCapacity)
+		{
+			return GrowResult::AtMaxCapacity;
+		}
+
+		// Until the first commit succeeds, entries stay in the initial storage
+		if (m_reserved == nullptr)
+		{
+			m_reserved = static_cast<T*>(m_reserve(sizeof(T) * m_maxCapacity));
+			if (m_reserved == nullptr)
+			{
+				return GrowResult::Failed;
+			}
+		}
+
+		// Freshly committed pages are zeroed, so new entries don't need clearing
+		if (!m_commit(m_reserved, sizeof(T) * newCapacity))
+		{
+			return GrowResult::Failed;
+		}
+
+		const bool moved = m_data != m_reserved;
+		if (moved)
+		{
+			std::copy_n(m_data, m_capacity, m_reserved);
+			m_data = m_reserved;
+		}
+		m_capacity = newCapacity;
+		return moved ? GrowResult::Moved : GrowResult::Grown;
+	}
+
+private:
+	ReserveFunc m_reserve = nullptr;
+	CommitFunc m_commit = nullptr;
+	size_t m_pageSize = 0;
+	size_t m_maxCapacity = 0;
+	T* m_reserved = nullptr;
+	T* m_data = nullptr;
+	size_t m_capacity = 0;
+};
@@ -0,0 +1,191 @@
+#include "Signature.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIGNATURE_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SIGNATURE_SIMD) && !defined(_MSC_VER)
+#define SIGNATURE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIGNATURE_TARGET_AVX2
+#endif
+
+namespace Signatures
+{
+	static bool ConfirmScalar(const SignatureView& sig, const uint8_t* candidate, size_t start)
+	{
+		for (size_t i = start; i < sig.size; i++)
+		{
+			if ((candidate[i] & sig.mask[i]) != sig.bytes[i]) return false;
+		}
+		return true;
+	}
+
+	// Range of addresses the anchor byte can be at, so the entire signature fits in [begin, end)
+	static bool GetAnchorRange(const SignatureView& sig, const uint8_t* begin, const uint8_t* end, const uint8_t*& first, const uint8_t*& last)
+	{
+		if (static_cast<size_t>(end - begin) < sig.size) return false;
+
+		first = begin + sig.anchor;
+		last = end - sig.size + sig.anchor;
+		return true;
+	}
+
+	static void ScanScalar(const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults)
+	{
+		const uint8_t* first;
+		const uint8_t* last;
+		if (!GetAnchorRange(sig, begin, end, first, last)) return;
+
+		const uint8_t anchorByte = sig.bytes[sig.anchor];
+		for (const uint8_t* p = first; p <= last; p++)
+		{
+			if (*p == anchorByte)
+			{
+				const uint8_t* candidate = p - sig.anchor;
+				if (ConfirmScalar(sig, candidate, 0))
+				{
+					results.push_back(candidate);
+					if (results.size() >= maxResults) return;
+				}
+			}
+		}
+	}
+
+#ifdef SIGNATURE_SIMD
+	static bool ConfirmSSE2(const SignatureView& sig, const uint8_t* candidate)
+	{
+		size_t i = 0;
+		for (; i + 16 <= sig.size; i += 16)
+		{
+			const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidate + i));
+			const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sig.mask + i));
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sig.bytes + i));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(data, mask), bytes)) != 0xFFFF) return false;
+		}
+		return ConfirmScalar(sig, candidate, i);
+	}
+
+	static unsigned int CountTrailingZeroes(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return index;
+#else
+		return __builtin_ctz(value);
+#endif
+	}
+
+	// Returns false if maxResults has been reached
+	static bool ConfirmCandidates(const SignatureView& sig, const uint8_t* base, uint32_t hits, std::vector<const uint8_t*>& results, size_t maxResults)
+	{
+		while (hits != 0)
+		{
+			const uint8_t* candidate = base + CountTrailingZeroes(hits) - sig.anchor;
+			if (ConfirmSSE2(sig, candidate))
+			{
+				results.push_back(candidate);
+				if (results.size() >= maxResults) return false;
+			}
+			hits &= hits - 1;
+		}
+		return true;
+	}
+
+	static void ScanSSE2(const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults)
+	{
+		const uint8_t* first;
+		const uint8_t* last;
+		if (!GetAnchorRange(sig, begin, end, first, last)) return;
+
+		const __m128i anchorByte = _mm_set1_epi8(static_cast<char>(sig.bytes[sig.anchor]));
+		const uint8_t* p = first;
+		for (; p + 16 <= last + 1; p += 16)
+		{
+			const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			const uint32_t hits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(data, anchorByte)));
+			if (!ConfirmCandidates(sig, p, hits, results, maxResults)) return;
+		}
+		ScanScalar(sig, p - sig.anchor, end, results, maxResults);
+	}
+
+	SIGNATURE_TARGET_AVX2 static void ScanAVX2(const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults)
+	{
+		const uint8_t* first;
+		const uint8_t* last;
+		if (!GetAnchorRange(sig, begin, end, first, last)) return;
+
+		const __m256i anchorByte = _mm256_set1_epi8(static_cast<char>(sig.bytes[sig.anchor]));
+		const uint8_t* p = first;
+		for (; p + 32 <= last + 1; p += 32)
+		{
+			const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			const uint32_t hits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, anchorByte)));
+			if (!ConfirmCandidates(sig, p, hits, results, maxResults)) return;
+		}
+		ScanSSE2(sig, p - sig.anchor, end, results, maxResults);
+	}
+
+	static bool IsAVX2Supported()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// OSXSAVE and AVX, then the OS must save the YMM registers
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+		if ((_xgetbv(0) & 6) != 6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	void Scan(const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults)
+	{
+#ifdef SIGNATURE_SIMD
+		static const bool useAVX2 = IsAVX2Supported();
+		if (useAVX2)
+		{
+			ScanAVX2(sig, begin, end, results, maxResults);
+		}
+		else
+		{
+			ScanSSE2(sig, begin, end, results, maxResults);
+		}
+#else
+		ScanScalar(sig, begin, end, results, maxResults);
+#endif
+	}
+
+	bool ScanWith(Implementation impl, const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults)
+	{
+		switch (impl)
+		{
+		case Implementation::Scalar:
+			ScanScalar(sig, begin, end, results, maxResults);
+			return true;
+#ifdef SIGNATURE_SIMD
+		case Implementation::SSE2:
+			ScanSSE2(sig, begin, end, results, maxResults);
+			return true;
+		case Implementation::AVX2:
+			if (!IsAVX2Supported()) return false;
+			ScanAVX2(sig, begin, end, results, maxResults);
+			return true;
+#endif
+		default:
+			return false;
+		}
+	}
+}
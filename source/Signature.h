@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Byte signatures compiled from "83 EC 08 ? ? ?" style strings at compile time,
+// and a scanner finding them in memory.
+namespace Signatures
+{
+	namespace detail
+	{
+		constexpr bool IsSeparator(char ch)
+		{
+			return ch == ' ';
+		}
+
+		constexpr uint8_t HexValue(char ch)
+		{
+			if (ch >= '0' && ch <= '9') return static_cast<uint8_t>(ch - '0');
+			if (ch >= 'A' && ch <= 'F') return static_cast<uint8_t>(ch - 'A' + 10);
+			if (ch >= 'a' && ch <= 'f') return static_cast<uint8_t>(ch - 'a' + 10);
+			throw std::invalid_argument("Invalid character in a signature");
+		}
+
+		// Like hook::pattern, every '?' is a wildcard byte of its own and hex digits pair up into bytes
+		template<size_t Len>
+		constexpr size_t CountBytes(const char (&str)[Len])
+		{
+			size_t wildcards = 0, digits = 0;
+			for (size_t i = 0; i < Len - 1; i++)
+			{
+				if (str[i] == '?')
+				{
+					wildcards++;
+				}
+				else if (!IsSeparator(str[i]))
+				{
+					digits++;
+				}
+			}
+			return wildcards + digits / 2;
+		}
+
+		// Approximate ranking of the most common bytes in x86 code, most common first.
+		// Anything not listed is considered rare.
+		constexpr uint8_t COMMON_BYTES[] = {
+			0x00, 0xFF, 0x8B, 0x24, 0x89, 0x44, 0x04, 0x08, 0x83, 0xE8, 0x85, 0xC0, 0x0C, 0x10, 0x01, 0x50,
+			0x56, 0x57, 0x53, 0x33, 0x74, 0x75, 0x8D, 0x6A, 0x68, 0x5E, 0x5F, 0x5B, 0xC3, 0x0F, 0x4C, 0x54,
+			0x14, 0x18, 0x1C, 0x20, 0x45, 0x46, 0x55, 0x5D, 0xCC, 0x90, 0xC7, 0x3B, 0x84, 0xEB, 0xE9, 0xA1,
+			0xD9, 0xDD, 0xDC, 0x80, 0x02, 0x03, 0x0D, 0x15, 0x35, 0x3D, 0x05, 0xF8, 0xFE, 0xC4, 0xEC, 0x81,
+		};
+
+		constexpr size_t ByteFrequencyRank(uint8_t byte)
+		{
+			constexpr size_t numCommon = sizeof(COMMON_BYTES) / sizeof(COMMON_BYTES[0]);
+			for (size_t i = 0; i < numCommon; i++)
+			{
+				if (COMMON_BYTES[i] == byte) return numCommon - i;
+			}
+			return 0;
+		}
+	}
+
+	// Non-owning view of a compiled signature, consumed by the scanner
+	struct SignatureView
+	{
+		const uint8_t* bytes; // Wildcards are stored as zeroes
+		const uint8_t* mask; // 0xFF - must match, 0x00 - wildcard
+		size_t size;
+		size_t anchor; // Index of the rarest non-wildcard byte, candidates are searched for by this byte
+	};
+
+	template<size_t N>
+	struct Signature
+	{
+		static_assert(N > 0, "Empty signature");
+
+		uint8_t bytes[N] {};
+		uint8_t mask[N] {};
+		size_t anchor = 0;
+
+		constexpr size_t size() const { return N; }
+		SignatureView view() const { return { bytes, mask, N, anchor }; }
+	};
+
+	template<size_t N, size_t Len>
+	constexpr Signature<N> Compile(const char (&str)[Len])
+	{
+		Signature<N> sig;
+
+		size_t index = 0;
+		for (size_t i = 0; i < Len - 1; )
+		{
+			if (detail::IsSeparator(str[i]))
+			{
+				i++;
+				continue;
+			}
+
+			if (str[i] == '?')
+			{
+				sig.bytes[index] = 0;
+				sig.mask[index] = 0;
+				i++;
+			}
+			else
+			{
+				// Stricter than hook::pattern, which also pairs up digits split by spaces
+				if (i + 1 >= Len - 1 || detail::IsSeparator(str[i + 1]) || str[i + 1] == '?')
+				{
+					throw std::invalid_argument("Signature bytes must be two hex digits long");
+				}
+				sig.bytes[index] = static_cast<uint8_t>((detail::HexValue(str[i]) << 4) | detail::HexValue(str[i + 1]));
+				sig.mask[index] = 0xFF;
+				i += 2;
+			}
+			index++;
+		}
+
+		bool hasFixedByte = false;
+		size_t bestRank = 0;
+		for (size_t i = 0; i < N; i++)
+		{
+			if (sig.mask[i] == 0) continue;
+
+			const size_t rank = detail::ByteFrequencyRank(sig.bytes[i]);
+			if (!hasFixedByte || rank < bestRank)
+			{
+				hasFixedByte = true;
+				bestRank = rank;
+				sig.anchor = i;
+			}
+		}
+		if (!hasFixedByte)
+		{
+			throw std::invalid_argument("Signature consists of wildcards only");
+		}
+		return sig;
+	}
+
+	// Appends up to maxResults matches found in [begin, end) to results
+	void Scan(const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults = SIZE_MAX);
+
+	enum class Implementation { Scalar, SSE2, AVX2 };
+
+	// Same as Scan, with the implementation forced, so they can be tested and benchmarked against each other.
+	// Returns false if the implementation is not available in this build or on this CPU
+	bool ScanWith(Implementation impl, const SignatureView& sig, const uint8_t* begin, const uint8_t* end, std::vector<const uint8_t*>& results, size_t maxResults = SIZE_MAX);
+}
+
+// Compiles a signature string at compile time, malformed signatures fail to compile
+#define SIGNATURE(str) ([]() { constexpr auto sig = ::Signatures::Compile<::Signatures::detail::CountBytes(str)>(str); return sig; }())
@@ -9,9 +9,23 @@
 #include "Utils/MemoryMgr.h"
 #include "Utils/Patterns.h"
 
+#include "LiveStats.h"
+#include "MirrorGovernor.h"
+#include "Prefetch.h"
+#include "ReservedArray.h"
+#include "Signature.h"
+#include "VTableHook.h"
+
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstdio>
 #include <functional>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include <wrl/client.h>
@@ -23,7 +37,15 @@ BOOL UseMetric = TRUE;
 bool ShowSteeringWheel = true;
 bool ShowArms = true;
 bool FullRangeSteeringAnims = false;
+bool IdleWhenInactive = true;
+bool DirectDrawStats = false;
+bool AllocStats = false;
+bool FastExit = false;
 uint16_t InCarMirrorRes = 64;
+double MirrorFrameBudget = 0.0;
+uint32_t ConfigEpoch = 0;
+bool PrefetchCarFiles = false;
+std::wstring PrefetchPaths;
 
 struct ModelEntity
 {
@@ -81,6 +103,55 @@ struct ArmsStruct
 
 ArmsStruct* gArms;
 
+namespace Features
+{
+	void MarkApplied(const wchar_t* id);
+}
+
+namespace DeferredHooks
+{
+	static std::vector<std::pair<const wchar_t*, std::function<void()>>> resolvedPatches;
+	static std::atomic<bool> patchesResolved = false;
+	static HANDLE hResolveThread;
+
+	static void ApplyPatches()
+	{
+		{
+			std::unique_ptr<ScopedUnprotect::Unprotect> Protect = ScopedUnprotect::UnprotectSectionOrFullModule( GetModuleHandle( nullptr ), ".text" );
+			for (const auto& patch : resolvedPatches)
+			{
+				patch.second();
+			}
+		}
+		FlushInstructionCache(GetCurrentProcess(), nullptr, 0);
+
+		for (const auto& patch : resolvedPatches)
+		{
+			Features::MarkApplied(patch.first);
+		}
+
+		resolvedPatches.clear();
+		resolvedPatches.shrink_to_fit();
+	}
+
+	// Called from the game thread, so none of the patched code can be mid-execution
+	void ApplyResolvedPatches()
+	{
+		if (hResolveThread == nullptr || !patchesResolved.load(std::memory_order_acquire))
+		{
+			return;
+		}
+
+		ApplyPatches();
+
+		CloseHandle(hResolveThread);
+		hResolveThread = nullptr;
+	}
+}
+
+// Per-frame work of all fixes, ran on the game thread
+static void OnNewFrame();
+
 bool* m_isWindowActive;
 namespace Timers
 {
@@ -93,6 +164,20 @@ namespace Timers
 	static int64_t lastTickTime;
 	static int64_t lastTickRemainder;
 	static bool resetTimers;
+
+	double lastFrameTime; // In milliseconds
+
+	// Set from the window procedure
+	static bool windowInactive;
+	void SetWindowInactive(bool inactive)
+	{
+		if (windowInactive && !inactive)
+		{
+			resetTimers = true;
+		}
+		windowInactive = inactive;
+	}
+
 	void __stdcall InitTimers()
 	{
 		resetTimers = true;
@@ -109,6 +194,13 @@ namespace Timers
 
 	void __stdcall TickTimers()
 	{
+		// The game keeps spinning its loop while alt-tabbed or minimized,
+		// so sleep until a message arrives instead (or until a timeout, so the loop still ticks)
+		if (IdleWhenInactive && windowInactive && !*m_isWindowActive)
+		{
+			MsgWaitForMultipleObjects(0, nullptr, FALSE, 100, QS_ALLINPUT);
+		}
+
 		LARGE_INTEGER time;
 		QueryPerformanceCounter(&time);
 		int tickTime = 0;
@@ -128,7 +220,10 @@ namespace Timers
 
 		*m_lastTick = tickTime;
 		*m_currentTime += tickTime;
+		lastFrameTime = static_cast<double>(time.QuadPart - lastTickTime) * 1000.0 / timerDenominator;
 		lastTickTime = time.QuadPart;
+
+		OnNewFrame();
 	}
 
 	void __stdcall WaitTimer(int duration)
@@ -238,23 +333,40 @@ namespace WidescreenFix
 		}
 	}
 
-	static double FOVNormalMult = 1.0; // Arbitrary values, shown to the user as 70deg by default
-	static double FOVDashboardMult = 1.0;
+	// Precomputed whenever the config is read, so the projection setup only has to apply the aspect ratio
+	struct FOVConstants
+	{
+		double horizontal; // Before applying the aspect ratio
+		float vertical;
+	};
+	static FOVConstants FOVNormal { 2.0 * 4.0 / 3.0, 2.5f };
+	static FOVConstants FOVDashboard { 2.0 * 4.0 / 3.0, 2.5f };
+
+	// Arbitrary values, shown to the user as 70deg for 1.0
+	void SetFOVMultipliers(double normalMult, double dashboardMult)
+	{
+		constexpr double AR_HOR_CONSTANT = 2.0 * 4.0 / 3.0;
+		constexpr double AR_VERT_CONSTANT = 2.5;
+		FOVNormal = { AR_HOR_CONSTANT * normalMult, static_cast<float>(AR_VERT_CONSTANT * normalMult) };
+		FOVDashboard = { AR_HOR_CONSTANT * dashboardMult, static_cast<float>(AR_VERT_CONSTANT * dashboardMult) };
+	}
+
 	uint32_t (__stdcall* GetCurrentCamera)(int camID);
+	static uint32_t currentCamera;
+	static bool viewportHooked = false;
+	static bool viewportSetThisFrame = false;
 	
 	static float horizontalFOV = 2.0f;
 	static float verticalFOV = 2.5f;
 	void __stdcall SetViewport_CalculateAR(int width, int unk1, int unk2, int unk3, int height, int unk4)
 	{
-		const double currentInvAR = static_cast<double>(m_currentRes->height) / m_currentRes->width;
-
 		uint32_t camID = GetCurrentCamera(0);
-		const double FOVMult = camID == 2 || camID == 4 ? FOVDashboardMult : FOVNormalMult;
+		currentCamera = camID;
+		viewportSetThisFrame = true;
+		const FOVConstants& FOV = camID == 2 || camID == 4 ? FOVDashboard : FOVNormal;
 
-		constexpr double AR_HOR_CONSTANT = 2.0 * 4.0 / 3.0;
-		constexpr double AR_VERT_CONSTANT = 2.5;
-		horizontalFOV = static_cast<float>(AR_HOR_CONSTANT * FOVMult * currentInvAR);
-		verticalFOV = static_cast<float>(AR_VERT_CONSTANT * FOVMult);
+		horizontalFOV = static_cast<float>(FOV.horizontal * m_currentRes->height / m_currentRes->width);
+		verticalFOV = FOV.vertical;
 
 		SetViewport_Thunk(width, unk1, unk2, unk3, height, unk4);
 	}
@@ -276,46 +388,147 @@ namespace DynamicAllocList
 	uint32_t* m_currentAllocSize;
 	void* (__stdcall* orgMaybeAlloc)(uint32_t size, uint8_t flags);
 
-	static void* currentMemSpace; // At first it points at the game variable, then at currentDynamicAlloc
-	static size_t currentAllocCapacity = 1024;
-	static void* currentDynamicAlloc = nullptr;
-	static std::function<void()> rePatchFunc;
+	// At first it lives in the game variable - unlike the realloc'd list it replaces, it can't grow past MAX_ALLOC_CAPACITY
+	static ReservedArray<void*> allocList;
+	static std::function<void(bool patchBase)> rePatchFunc;
+
+	static constexpr size_t GAME_ALLOC_CAPACITY = 1024;
+	static constexpr size_t MAX_ALLOC_CAPACITY = 1024 * 1024;
+
+	static void* ReserveMemory(size_t size)
+	{
+		return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE);
+	}
+
+	static bool CommitMemory(void* address, size_t size)
+	{
+		return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+	}
+
+	// Histogram of the allocations going through this path, in power of two size classes - only with AllocStats=1
+	static LiveStats::AllocHistogram allocHistogram;
+	static uint32_t allocFlagsCounts[256];
+	static int64_t allocTicks;
+
+	static LiveStats::RestoreAllocations restoreStats;
+	static int64_t restoreAllocTicks;
+
+	static size_t GetSizeClass(uint32_t size)
+	{
+		size_t sizeClass = 0;
+		uint32_t classSize = LiveStats::ALLOC_SMALLEST_SIZE_CLASS;
+		while (classSize < size && sizeClass < LiveStats::NUM_ALLOC_SIZE_CLASSES - 1)
+		{
+			classSize *= 2;
+			sizeClass++;
+		}
+		return sizeClass;
+	}
+
+	const LiveStats::AllocHistogram& GetHistogram()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		allocHistogram.allocationTimeMicroseconds = static_cast<uint32_t>(allocTicks * 1000000 / frequency.QuadPart);
+		return allocHistogram;
+	}
+
+	void ReportHistogram()
+	{
+		if (!AllocStats) return;
+
+		GetHistogram();
+
+		char buffer[128];
+		sprintf_s(buffer, "SilentPatch: %u allocations, %.2f ms spent allocating\n",
+			allocHistogram.numAllocations, allocHistogram.allocationTimeMicroseconds / 1000.0);
+		OutputDebugStringA(buffer);
+
+		uint32_t classSize = LiveStats::ALLOC_SMALLEST_SIZE_CLASS;
+		for (uint32_t count : allocHistogram.sizeClassCounts)
+		{
+			if (count != 0)
+			{
+				sprintf_s(buffer, "SilentPatch:   <= %u bytes: %u\n", classSize, count);
+				OutputDebugStringA(buffer);
+			}
+			classSize *= 2;
+		}
+		for (size_t i = 0; i < std::size(allocFlagsCounts); i++)
+		{
+			if (allocFlagsCounts[i] != 0)
+			{
+				sprintf_s(buffer, "SilentPatch:   flags %02X: %u\n", static_cast<unsigned int>(i), allocFlagsCounts[i]);
+				OutputDebugStringA(buffer);
+			}
+		}
+	}
 
 	void* __stdcall MaybeAllocAndExpandArray(uint32_t size, uint8_t flags)
 	{
 		const uint32_t curIndexToUse = *m_currentAllocSize;
-		if (curIndexToUse >= currentAllocCapacity)
+		if (curIndexToUse >= allocList.GetCapacity())
 		{
-			// If it's the first time we reallocate, it'll redirect from the game variable to a custom allocation
-			const size_t newCapacity = 2 * currentAllocCapacity;
-			void* newMem = realloc(currentDynamicAlloc, sizeof(void*) * newCapacity);
-			if (newMem != nullptr)
+			const auto result = allocList.Grow();
+			if (result == ReservedArray<void*>::GrowResult::AtMaxCapacity)
 			{
-				if (currentDynamicAlloc == nullptr)
+				static bool capacityReported = false;
+				if (!capacityReported)
 				{
-					// This is the first time allocating, copy the data over from the game allocation
-					// Further reallocations will implicitly copy the data over
-					void** src = static_cast<void**>(currentMemSpace);
-					void** dest = static_cast<void**>(newMem);
-					std::copy_n(src, currentAllocCapacity, dest);
+					capacityReported = true;
+					OutputDebugStringA("SilentPatch: Allocation list reached its maximum capacity and will not grow further\n");
 				}
-
-				void** mem = static_cast<void**>(newMem);
-				std::fill(mem+currentAllocCapacity, mem+newCapacity, nullptr);
-
-				currentDynamicAlloc = currentMemSpace = newMem;
-				currentAllocCapacity = newCapacity;
-
-				rePatchFunc();
+			}
+			else if (result != ReservedArray<void*>::GrowResult::Failed)
+			{
+				rePatchFunc(result == ReservedArray<void*>::GrowResult::Moved);
 			}
 		}
+		if (!AllocStats)
+		{
+			return orgMaybeAlloc(size, flags);
+		}
+
+		LARGE_INTEGER startTime, endTime;
+		QueryPerformanceCounter(&startTime);
 		void* returnMem = orgMaybeAlloc(size, flags);
+		QueryPerformanceCounter(&endTime);
+
+		allocHistogram.sizeClassCounts[GetSizeClass(size)]++;
+		allocHistogram.numAllocations++;
+		allocTicks += endTime.QuadPart - startTime.QuadPart;
+		allocFlagsCounts[flags]++;
+
+		restoreStats.allocations++;
+		restoreAllocTicks += endTime.QuadPart - startTime.QuadPart;
 		return returnMem;
 	}
+
+	// Minimizing and restoring over and over is what used to overflow the list,
+	// so every restore starts counting anew, to tell what a single restore costs and if the list keeps growing
+	void OnRestore()
+	{
+		if (!AllocStats) return;
+
+		restoreStats.numRestores++;
+		restoreStats.allocations = 0;
+		restoreAllocTicks = 0;
+	}
+
+	const LiveStats::RestoreAllocations& GetRestoreStats()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		restoreStats.allocationTimeMicroseconds = static_cast<uint32_t>(restoreAllocTicks * 1000000 / frequency.QuadPart);
+		return restoreStats;
+	}
 }
 
 LPDIRECTDRAW* g_pDirectDraw;
 void (__stdcall* RegisterDestructor)(BOOL (__stdcall* func)(), const char* name);
+static BOOL* bRequestsExit;
+
+
 namespace DynamicPalettesList
 {
 	using Microsoft::WRL::ComPtr;
@@ -324,6 +537,16 @@ namespace DynamicPalettesList
 
 	BOOL __stdcall PalettesDestructor()
 	{
+		// The process is about to exit, so leave the palettes to DirectDraw, which frees them along with itself,
+		// instead of releasing thousands of them one by one
+		const bool exiting = bRequestsExit != nullptr && *bRequestsExit;
+		if (FastExit && exiting)
+		{
+			for (auto& palette : createdPalettes)
+			{
+				palette.Detach();
+			}
+		}
 		createdPalettes.clear();
 		return TRUE;
 	}
@@ -356,9 +579,546 @@ namespace DynamicPalettesList
 	}
 }
 
+// Counts DirectDraw calls per frame and times presenting, by patching the vtables of the game's DirectDraw objects.
+// Only the IDirectDraw and IDirectDrawSurface interfaces are covered, calls made via newer interface versions are not counted.
+namespace DirectDrawCallStats
+{
+	// IDirectDraw vtable
+	static constexpr size_t VTBL_CREATE_PALETTE = 5;
+	static constexpr size_t VTBL_CREATE_SURFACE = 6;
+
+	// IDirectDrawSurface vtable
+	static constexpr size_t VTBL_BLT = 5;
+	static constexpr size_t VTBL_FLIP = 11;
+	static constexpr size_t VTBL_LOCK = 25;
+	static constexpr size_t VTBL_UNLOCK = 32;
+
+	static LiveStats::DirectDrawFrameStats currentFrame, lastFrame;
+	static int64_t flipTicks;
+	static int64_t lastFlipTime;
+	static int64_t lastFlipInterval;
+	static bool directDrawHooked = false, surfaceHooked = false;
+
+	template<typename T>
+	static void PatchVTable(void* object, size_t index, T hook, T& original)
+	{
+		VTableHook::Hook(object, index, hook, original, [](void* address, size_t size, const auto& write)
+		{
+			DWORD oldProtect;
+			if (VirtualProtect(address, size, PAGE_EXECUTE_READWRITE, &oldProtect) == FALSE)
+			{
+				return false;
+			}
+			write();
+			VirtualProtect(address, size, oldProtect, &oldProtect);
+			return true;
+		});
+	}
+
+	static HRESULT (STDMETHODCALLTYPE* orgBlt)(IDirectDrawSurface* self, LPRECT destRect, LPDIRECTDRAWSURFACE srcSurface, LPRECT srcRect, DWORD flags, LPDDBLTFX bltFx);
+	static HRESULT STDMETHODCALLTYPE Blt_Count(IDirectDrawSurface* self, LPRECT destRect, LPDIRECTDRAWSURFACE srcSurface, LPRECT srcRect, DWORD flags, LPDDBLTFX bltFx)
+	{
+		currentFrame.numBlt++;
+		return orgBlt(self, destRect, srcSurface, srcRect, flags, bltFx);
+	}
+
+	static HRESULT (STDMETHODCALLTYPE* orgFlip)(IDirectDrawSurface* self, LPDIRECTDRAWSURFACE targetOverride, DWORD flags);
+	static HRESULT STDMETHODCALLTYPE Flip_Time(IDirectDrawSurface* self, LPDIRECTDRAWSURFACE targetOverride, DWORD flags)
+	{
+		LARGE_INTEGER startTime, endTime;
+		QueryPerformanceCounter(&startTime);
+		const HRESULT result = orgFlip(self, targetOverride, flags);
+		QueryPerformanceCounter(&endTime);
+
+		currentFrame.numFlip++;
+		flipTicks += endTime.QuadPart - startTime.QuadPart;
+		if (lastFlipTime != 0)
+		{
+			lastFlipInterval = endTime.QuadPart - lastFlipTime;
+		}
+		lastFlipTime = endTime.QuadPart;
+		return result;
+	}
+
+	static HRESULT (STDMETHODCALLTYPE* orgLock)(IDirectDrawSurface* self, LPRECT destRect, LPDDSURFACEDESC surfaceDesc, DWORD flags, HANDLE event);
+	static HRESULT STDMETHODCALLTYPE Lock_Count(IDirectDrawSurface* self, LPRECT destRect, LPDDSURFACEDESC surfaceDesc, DWORD flags, HANDLE event)
+	{
+		currentFrame.numLock++;
+		return orgLock(self, destRect, surfaceDesc, flags, event);
+	}
+
+	static HRESULT (STDMETHODCALLTYPE* orgUnlock)(IDirectDrawSurface* self, LPVOID surfaceData);
+	static HRESULT STDMETHODCALLTYPE Unlock_Count(IDirectDrawSurface* self, LPVOID surfaceData)
+	{
+		currentFrame.numUnlock++;
+		return orgUnlock(self, surfaceData);
+	}
+
+	// All surfaces share the vtable, so hooking any one of them is enough
+	static void HookSurface(IDirectDrawSurface* surface)
+	{
+		surfaceHooked = true;
+		PatchVTable(surface, VTBL_BLT, Blt_Count, orgBlt);
+		PatchVTable(surface, VTBL_FLIP, Flip_Time, orgFlip);
+		PatchVTable(surface, VTBL_LOCK, Lock_Count, orgLock);
+		PatchVTable(surface, VTBL_UNLOCK, Unlock_Count, orgUnlock);
+	}
+
+	static HRESULT WINAPI EnumSurfacesCB_Hook(LPDIRECTDRAWSURFACE surface, LPDDSURFACEDESC, LPVOID)
+	{
+		HookSurface(surface);
+		surface->Release();
+		return DDENUMRET_CANCEL;
+	}
+
+	// Only if no surfaces existed yet when the hooks went in
+	static HRESULT (STDMETHODCALLTYPE* orgCreateSurface)(IDirectDraw* self, LPDDSURFACEDESC surfaceDesc, LPDIRECTDRAWSURFACE* surface, IUnknown* outer);
+	static HRESULT STDMETHODCALLTYPE CreateSurface_Count(IDirectDraw* self, LPDDSURFACEDESC surfaceDesc, LPDIRECTDRAWSURFACE* surface, IUnknown* outer)
+	{
+		currentFrame.numCreateSurface++;
+		const HRESULT result = orgCreateSurface(self, surfaceDesc, surface, outer);
+		if (SUCCEEDED(result) && !surfaceHooked)
+		{
+			HookSurface(*surface);
+		}
+		return result;
+	}
+
+	static HRESULT (STDMETHODCALLTYPE* orgCreatePalette)(IDirectDraw* self, DWORD flags, LPPALETTEENTRY entries, LPDIRECTDRAWPALETTE* palette, IUnknown* outer);
+	static HRESULT STDMETHODCALLTYPE CreatePalette_Count(IDirectDraw* self, DWORD flags, LPPALETTEENTRY entries, LPDIRECTDRAWPALETTE* palette, IUnknown* outer)
+	{
+		currentFrame.numCreatePalette++;
+		return orgCreatePalette(self, flags, entries, palette, outer);
+	}
+
+	void OnNewFrame()
+	{
+		if (!directDrawHooked)
+		{
+			if (!DirectDrawStats || g_pDirectDraw == nullptr || *g_pDirectDraw == nullptr) return;
+
+			directDrawHooked = true;
+			PatchVTable(*g_pDirectDraw, VTBL_CREATE_SURFACE, CreateSurface_Count, orgCreateSurface);
+			PatchVTable(*g_pDirectDraw, VTBL_CREATE_PALETTE, CreatePalette_Count, orgCreatePalette);
+
+			// The primary surface and its back buffers are long created by now, take any existing surface
+			(*g_pDirectDraw)->EnumSurfaces(DDENUMSURFACES_DOESEXIST|DDENUMSURFACES_ALL, nullptr, nullptr, EnumSurfacesCB_Hook);
+		}
+
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		currentFrame.flipMicroseconds = static_cast<uint32_t>(flipTicks * 1000000 / frequency.QuadPart);
+		currentFrame.flipIntervalMicroseconds = static_cast<uint32_t>(lastFlipInterval * 1000000 / frequency.QuadPart);
+
+		lastFrame = currentFrame;
+		currentFrame = {};
+		flipTicks = 0;
+	}
+}
+
+// The game's table of D3D resources, with a 1132 bytes long info entry per resource
+namespace D3DResources
+{
+	static constexpr size_t ENTRY_SIZE = 1132;
+	static constexpr size_t ENTRY_SIZE_OFFSET = 4;
+
+	static void* entriesInfo;
+
+	uint16_t* GetEntrySize(uint32_t id)
+	{
+		std::byte* entry = static_cast<std::byte*>(entriesInfo) + ENTRY_SIZE*id;
+		return reinterpret_cast<uint16_t*>(entry + ENTRY_SIZE_OFFSET);
+	}
+}
+
+// Accounts for the memory taken by all DirectDraw surfaces the game has created
+namespace SurfaceInspector
+{
+	static uint32_t framesUntilInspection = 0;
+	static uint32_t mirrorSurfaceID;
+	static LiveStats::SurfaceMemory lastResults;
+	static LiveStats::SurfaceFormats lastFormats[static_cast<size_t>(LiveStats::SurfaceCategory::NumCategories)];
+
+	struct Results
+	{
+		LiveStats::SurfaceMemory memory;
+		LiveStats::SurfaceFormats formats[static_cast<size_t>(LiveStats::SurfaceCategory::NumCategories)];
+	};
+
+	// Surfaces are (re)created over the next frames, so don't inspect immediately
+	void RequestInspection()
+	{
+		framesUntilInspection = 3;
+	}
+
+	static LiveStats::SurfaceCategory CategorizeSurface(DWORD caps)
+	{
+		if ((caps & (DDSCAPS_PRIMARYSURFACE|DDSCAPS_BACKBUFFER|DDSCAPS_FRONTBUFFER|DDSCAPS_FLIP)) != 0)
+		{
+			return LiveStats::SurfaceCategory::Framebuffer;
+		}
+		if ((caps & DDSCAPS_ZBUFFER) != 0)
+		{
+			return LiveStats::SurfaceCategory::DepthBuffer;
+		}
+		if ((caps & DDSCAPS_3DDEVICE) != 0)
+		{
+			return LiveStats::SurfaceCategory::RenderTarget;
+		}
+		if ((caps & DDSCAPS_TEXTURE) != 0)
+		{
+			return LiveStats::SurfaceCategory::Texture;
+		}
+		return LiveStats::SurfaceCategory::Other;
+	}
+
+	static HRESULT WINAPI EnumSurfacesCB(LPDIRECTDRAWSURFACE pSurface, LPDDSURFACEDESC pSurfaceDesc, LPVOID context)
+	{
+		auto& results = static_cast<Results*>(context)->memory;
+		auto& formats = static_cast<Results*>(context)->formats;
+
+		uint32_t bytes;
+		if ((pSurfaceDesc->dwFlags & DDSD_PITCH) != 0)
+		{
+			bytes = pSurfaceDesc->lPitch * pSurfaceDesc->dwHeight;
+		}
+		else
+		{
+			bytes = pSurfaceDesc->dwWidth * pSurfaceDesc->dwHeight * (pSurfaceDesc->ddpfPixelFormat.dwRGBBitCount / 8);
+		}
+
+		const DWORD caps = pSurfaceDesc->ddsCaps.dwCaps;
+		const size_t category = static_cast<size_t>(CategorizeSurface(caps));
+		results.bytesPerCategory[category] += bytes;
+		results.surfacesPerCategory[category]++;
+
+		// Depth buffers keep their bit depth where the RGB bit count is
+		const DDPIXELFORMAT& pixelFormat = pSurfaceDesc->ddpfPixelFormat;
+		const uint32_t fourCC = (pixelFormat.dwFlags & DDPF_FOURCC) != 0 ? pixelFormat.dwFourCC : 0;
+		LiveStats::AddSurfaceFormat(formats[category], fourCC, pixelFormat.dwRGBBitCount);
+		if ((caps & DDSCAPS_SYSTEMMEMORY) != 0)
+		{
+			results.systemMemoryBytes += bytes;
+		}
+		else
+		{
+			results.videoMemoryBytes += bytes;
+		}
+
+		pSurface->Release();
+		return DDENUMRET_OK;
+	}
+
+	static void Inspect()
+	{
+		if (g_pDirectDraw == nullptr || *g_pDirectDraw == nullptr) return;
+
+		Results inspected {};
+		if (FAILED((*g_pDirectDraw)->EnumSurfaces(DDENUMSURFACES_DOESEXIST|DDENUMSURFACES_ALL, nullptr, &inspected, EnumSurfacesCB)))
+		{
+			return;
+		}
+		LiveStats::SurfaceMemory& results = inspected.memory;
+		if (D3DResources::entriesInfo != nullptr)
+		{
+			results.mirrorSurfaceSize = *D3DResources::GetEntrySize(mirrorSurfaceID);
+		}
+		lastResults = results;
+		std::copy(std::begin(inspected.formats), std::end(inspected.formats), std::begin(lastFormats));
+
+		char buffer[256];
+		sprintf_s(buffer, "SilentPatch: %u KB in surfaces (%u KB video, %u KB system) - framebuffers %u KB, depth %u KB, render targets %u KB, textures %u KB, other %u KB\n",
+			(results.videoMemoryBytes + results.systemMemoryBytes) / 1024, results.videoMemoryBytes / 1024, results.systemMemoryBytes / 1024,
+			results.bytesPerCategory[0] / 1024, results.bytesPerCategory[1] / 1024, results.bytesPerCategory[2] / 1024,
+			results.bytesPerCategory[3] / 1024, results.bytesPerCategory[4] / 1024);
+		OutputDebugStringA(buffer);
+
+		static constexpr const char* CATEGORY_NAMES[] = { "framebuffers", "depth", "render targets", "textures", "other" };
+		for (size_t category = 0; category < std::size(inspected.formats); category++)
+		{
+			int length = sprintf_s(buffer, "SilentPatch:   %s:", CATEGORY_NAMES[category]);
+			for (const LiveStats::SurfaceFormat& format : inspected.formats[category].formats)
+			{
+				if (format.numSurfaces == 0) break;
+				if (format.fourCC != 0)
+				{
+					const char* fourCC = reinterpret_cast<const char*>(&format.fourCC);
+					length += sprintf_s(buffer + length, std::size(buffer) - length, " %c%c%c%c x%u", fourCC[0], fourCC[1], fourCC[2], fourCC[3], format.numSurfaces);
+				}
+				else
+				{
+					length += sprintf_s(buffer + length, std::size(buffer) - length, " %u-bit x%u", format.bitCount, format.numSurfaces);
+				}
+			}
+			if (inspected.formats[category].numUnlistedSurfaces != 0)
+			{
+				length += sprintf_s(buffer + length, std::size(buffer) - length, " others x%u", inspected.formats[category].numUnlistedSurfaces);
+			}
+			sprintf_s(buffer + length, std::size(buffer) - length, "\n");
+			OutputDebugStringA(buffer);
+		}
+	}
+
+	void OnNewFrame()
+	{
+		if (framesUntilInspection != 0 && --framesUntilInspection == 0)
+		{
+			Inspect();
+		}
+	}
+}
+
 static double HUDScale = 1.0/480.0;
 static double GameMenuScale = 1.0/480.0;
 
+static HMODULE hDLLModule;
+static void GetModulePathWithExtension(wchar_t (&path)[MAX_PATH], const wchar_t* extension)
+{
+	GetModuleFileNameW(hDLLModule, path, static_cast<DWORD>(_countof(path) - wcslen(extension))); // Minus max required space for extension
+	PathRenameExtensionW(path, extension);
+}
+
+// Reads car skins and decals into the OS file cache ahead of the game loading them.
+// The files to read are learned from the loads themselves - whatever the game opens while loading skins and decals
+// gets recorded per player car and saved, so the next load with that car can be read ahead as soon as its roster is set up
+namespace SkinsPrefetch
+{
+	enum class FileSet { Skins, Decals, Num };
+
+	struct LearnedFiles
+	{
+		bool loaded = false;
+		std::vector<std::wstring> files[static_cast<size_t>(FileSet::Num)];
+	};
+	static LearnedFiles learnedFiles[256];
+
+	static constexpr size_t MAX_LEARNED_FILES = 256;
+
+	static int prefetchedCarID = -1;
+
+	static std::atomic<DWORD> recordingThreadID = 0;
+	static std::vector<std::wstring> recordedFiles;
+
+	static uint32_t GetElapsedMicroseconds(const LARGE_INTEGER& startTime)
+	{
+		LARGE_INTEGER time, frequency;
+		QueryPerformanceCounter(&time);
+		QueryPerformanceFrequency(&frequency);
+		return static_cast<uint32_t>((time.QuadPart - startTime.QuadPart) * 1000000 / frequency.QuadPart);
+	}
+
+	// Shared for writing and deleting too, so a read ahead never stops the game or mod tools from opening the same file
+	static void* OpenShared(const std::wstring& path)
+	{
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		return file != INVALID_HANDLE_VALUE ? file : nullptr;
+	}
+
+	static size_t ReadChunk(void* file, void* buffer, size_t size)
+	{
+		DWORD bytesRead;
+		return ReadFile(file, buffer, static_cast<DWORD>(size), &bytesRead, nullptr) != FALSE ? bytesRead : 0;
+	}
+
+	static void CloseFile(void* file)
+	{
+		CloseHandle(file);
+	}
+
+	static std::vector<std::wstring> FindFiles(const std::wstring& pattern)
+	{
+		std::vector<std::wstring> files;
+		const std::wstring directory = pattern.substr(0, pattern.find_last_of(L"\\/") + 1);
+
+		WIN32_FIND_DATAW findData;
+		HANDLE find = FindFirstFileW(pattern.c_str(), &findData);
+		if (find == INVALID_HANDLE_VALUE) return files;
+		do
+		{
+			if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+			{
+				files.push_back(directory + findData.cFileName);
+			}
+		}
+		while (FindNextFileW(find, &findData) != FALSE);
+		FindClose(find);
+		return files;
+	}
+
+	static Prefetch::ReadAheadQueue queue({ OpenShared, ReadChunk, CloseFile, FindFiles });
+
+	static DWORD WINAPI PrefetchThread(LPVOID)
+	{
+		queue.RunWorker();
+		return 0;
+	}
+
+	static void Queue(const std::vector<std::wstring>& paths)
+	{
+		if (queue.Add(paths))
+		{
+			HANDLE thread = CreateThread(nullptr, 0, PrefetchThread, nullptr, 0, nullptr);
+			if (thread == nullptr)
+			{
+				queue.OnWorkerFailedToStart();
+				return;
+			}
+			CloseHandle(thread);
+		}
+	}
+
+	static const wchar_t* GetFileSetName(FileSet set)
+	{
+		return set == FileSet::Skins ? L"Skins" : L"Decals";
+	}
+
+	static LearnedFiles& GetLearnedFiles(uint8_t carID)
+	{
+		LearnedFiles& learned = learnedFiles[carID];
+		if (!learned.loaded)
+		{
+			learned.loaded = true;
+
+			wchar_t wcPrefetchPath[MAX_PATH];
+			GetModulePathWithExtension(wcPrefetchPath, L".prefetch.ini");
+
+			wchar_t section[16];
+			swprintf_s(section, L"Car%u", carID);
+
+			std::vector<wchar_t> buffer(32767);
+			for (size_t i = 0; i < std::size(learned.files); i++)
+			{
+				GetPrivateProfileString(section, GetFileSetName(static_cast<FileSet>(i)), L"", buffer.data(), static_cast<DWORD>(buffer.size()), wcPrefetchPath);
+				learned.files[i] = Prefetch::ParseFileList(buffer.data());
+			}
+		}
+		return learned;
+	}
+
+	static void SaveLearnedFiles(uint8_t carID, FileSet set)
+	{
+		wchar_t wcPrefetchPath[MAX_PATH];
+		GetModulePathWithExtension(wcPrefetchPath, L".prefetch.ini");
+
+		wchar_t section[16];
+		swprintf_s(section, L"Car%u", carID);
+
+		const std::wstring list = Prefetch::JoinFileList(learnedFiles[carID].files[static_cast<size_t>(set)]);
+		WritePrivateProfileString(section, GetFileSetName(set), list.c_str(), wcPrefetchPath);
+	}
+
+	static void StartPrefetch(uint8_t carID, bool includeSkins)
+	{
+		prefetchedCarID = carID;
+		queue.ResetStats();
+
+		const LearnedFiles& learned = GetLearnedFiles(carID);
+		if (includeSkins)
+		{
+			Queue(learned.files[static_cast<size_t>(FileSet::Skins)]);
+		}
+		Queue(learned.files[static_cast<size_t>(FileSet::Decals)]);
+		Queue(Prefetch::ExpandPaths(PrefetchPaths, carID));
+	}
+
+	// Called as soon as the roster of a race is known, well before the game starts loading
+	void OnRosterSet(uint8_t carID)
+	{
+		if (PrefetchCarFiles && prefetchedCarID != carID)
+		{
+			StartPrefetch(carID, true);
+		}
+	}
+
+	void BeginLoad(uint8_t carID, FileSet set)
+	{
+		if (!PrefetchCarFiles) return;
+
+		// The roster was not seen ahead of the load - skins are being read by the game right now anyway,
+		// but decals can still be read ahead of it
+		if (set == FileSet::Skins && prefetchedCarID != carID)
+		{
+			StartPrefetch(carID, false);
+		}
+
+		recordedFiles.clear();
+		recordingThreadID.store(GetCurrentThreadId(), std::memory_order_release);
+	}
+
+	void EndLoad(uint8_t carID, FileSet set)
+	{
+		if (recordingThreadID.exchange(0, std::memory_order_acq_rel) == 0) return;
+
+		if (Prefetch::MergeRecordedFiles(GetLearnedFiles(carID).files[static_cast<size_t>(set)], recordedFiles))
+		{
+			SaveLearnedFiles(carID, set);
+		}
+
+		// Decals are already queued by now, and the next load wants a fresh prefetch even with the same car
+		if (set == FileSet::Skins)
+		{
+			prefetchedCarID = -1;
+		}
+	}
+
+	static HANDLE (WINAPI* orgCreateFileA)(LPCSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode, LPSECURITY_ATTRIBUTES lpSecurityAttributes,
+		DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes, HANDLE hTemplateFile);
+	static HANDLE WINAPI CreateFileA_Record(LPCSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode, LPSECURITY_ATTRIBUTES lpSecurityAttributes,
+		DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes, HANDLE hTemplateFile)
+	{
+		HANDLE file = orgCreateFileA(lpFileName, dwDesiredAccess, dwShareMode, lpSecurityAttributes, dwCreationDisposition, dwFlagsAndAttributes, hTemplateFile);
+
+		// Only the reads done by the loading thread while a load is being recorded
+		if (file != INVALID_HANDLE_VALUE && dwCreationDisposition == OPEN_EXISTING && (dwDesiredAccess & GENERIC_WRITE) == 0 &&
+			recordingThreadID.load(std::memory_order_acquire) == GetCurrentThreadId())
+		{
+			char fullPath[MAX_PATH];
+			wchar_t wcFullPath[MAX_PATH];
+			const DWORD length = GetFullPathNameA(lpFileName, _countof(fullPath), fullPath, nullptr);
+			if (length != 0 && length < _countof(fullPath) && MultiByteToWideChar(CP_ACP, 0, fullPath, -1, wcFullPath, _countof(wcFullPath)) != 0)
+			{
+				Prefetch::RecordFile(recordedFiles, wcFullPath, MAX_LEARNED_FILES);
+			}
+		}
+		return file;
+	}
+
+	// The game opens its files through the CRT, which ends up in the imported CreateFileA
+	void HookFileOpens()
+	{
+		HMODULE module = GetModuleHandle(nullptr);
+		auto* base = reinterpret_cast<uint8_t*>(module);
+		const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+		const auto* ntHeader = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dosHeader->e_lfanew);
+		const IMAGE_DATA_DIRECTORY& importDir = ntHeader->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+		if (importDir.VirtualAddress == 0) return;
+
+		for (auto* import = reinterpret_cast<const IMAGE_IMPORT_DESCRIPTOR*>(base + importDir.VirtualAddress); import->Name != 0; import++)
+		{
+			if (_stricmp(reinterpret_cast<const char*>(base + import->Name), "kernel32.dll") != 0 || import->OriginalFirstThunk == 0) continue;
+
+			auto* names = reinterpret_cast<const IMAGE_THUNK_DATA*>(base + import->OriginalFirstThunk);
+			auto* funcs = reinterpret_cast<IMAGE_THUNK_DATA*>(base + import->FirstThunk);
+			for (; names->u1.AddressOfData != 0; names++, funcs++)
+			{
+				if (IMAGE_SNAP_BY_ORDINAL(names->u1.Ordinal)) continue;
+
+				const auto* importName = reinterpret_cast<const IMAGE_IMPORT_BY_NAME*>(base + names->u1.AddressOfData);
+				if (strcmp(reinterpret_cast<const char*>(importName->Name), "CreateFileA") == 0)
+				{
+					DWORD dwProtect;
+					VirtualProtect(&funcs->u1.Function, sizeof(funcs->u1.Function), PAGE_READWRITE, &dwProtect);
+					orgCreateFileA = reinterpret_cast<decltype(orgCreateFileA)>(funcs->u1.Function);
+					funcs->u1.Function = reinterpret_cast<decltype(funcs->u1.Function)>(&CreateFileA_Record);
+					VirtualProtect(&funcs->u1.Function, sizeof(funcs->u1.Function), dwProtect, &dwProtect);
+					return;
+				}
+			}
+		}
+	}
+}
+
 namespace DecalsCrashFix
 {
 	struct CarDetails
@@ -372,6 +1132,8 @@ namespace DecalsCrashFix
 
 	static void** gUnkDecalResource;
 	static CarDetails** gCarsInRaceDetails;
+	static LiveStats::LoadTimes loadTimes;
+
 	static void (__stdcall* orgInitializeDecals)();
 	void __stdcall InitializeDecals_IDCheck()
 	{
@@ -380,7 +1142,14 @@ namespace DecalsCrashFix
 		{
 			if (gUnkDecalResource[0] != nullptr || gUnkDecalResource[1] != nullptr)
 			{
+				SkinsPrefetch::BeginLoad(details[0].m_carID, SkinsPrefetch::FileSet::Decals);
+
+				LARGE_INTEGER startTime;
+				QueryPerformanceCounter(&startTime);
 				orgInitializeDecals();
+				loadTimes.decalsLoadMicroseconds = SkinsPrefetch::GetElapsedMicroseconds(startTime);
+
+				SkinsPrefetch::EndLoad(details[0].m_carID, SkinsPrefetch::FileSet::Decals);
 			}
 		}
 	}
@@ -388,20 +1157,57 @@ namespace DecalsCrashFix
 	static void (__stdcall* orgSkinsLoad)();
 	void __stdcall SkinsLoad_NullCheck()
 	{
-		if ((*gCarsInRaceDetails) != nullptr)
+		const CarDetails* details = *gCarsInRaceDetails;
+		if (details != nullptr)
 		{
+			// Only the first entry of the roster is known to be valid here, so the player car keys the learned files
+			SkinsPrefetch::BeginLoad(details[0].m_carID, SkinsPrefetch::FileSet::Skins);
+			loadTimes.decalsLoadMicroseconds = 0;
+
+			LARGE_INTEGER startTime;
+			QueryPerformanceCounter(&startTime);
 			orgSkinsLoad();
+			loadTimes.skinsLoadMicroseconds = SkinsPrefetch::GetElapsedMicroseconds(startTime);
+
+			SkinsPrefetch::EndLoad(details[0].m_carID, SkinsPrefetch::FileSet::Skins);
 		}
 	}
+
+	// The roster gets filled in before the loading starts, so prefetching from here gives the reads a head start
+	void OnNewFrame()
+	{
+		static int lastRosterCarID = -1;
+
+		if (gCarsInRaceDetails == nullptr) return;
+
+		const CarDetails* details = *gCarsInRaceDetails;
+		const int carID = details != nullptr ? details[0].m_carID : -1;
+		if (carID != lastRosterCarID)
+		{
+			lastRosterCarID = carID;
+			if (carID >= 0)
+			{
+				SkinsPrefetch::OnRosterSet(static_cast<uint8_t>(carID));
+			}
+		}
+	}
+
+	const LiveStats::LoadTimes& GetLoadTimes()
+	{
+		loadTimes.prefetched = SkinsPrefetch::queue.GetFiles();
+		loadTimes.prefetchedBytes = SkinsPrefetch::queue.GetBytes();
+		loadTimes.prefetchMicroseconds = SkinsPrefetch::queue.GetMicroseconds();
+		return loadTimes;
+	}
 }
 
-static HMODULE hDLLModule;
-static void ReadINI(uint16_t* pMirror, bool* pHookMetricImperial, bool* pForcedMirrors)
+static void ReadINI(uint16_t* pMirror, bool* pHookMetricImperial, bool* pForcedMirrors, bool* pLiveStats)
 {
+	ConfigEpoch++;
+
 	wchar_t buffer[32];
 	wchar_t wcModulePath[MAX_PATH];
-	GetModuleFileNameW(hDLLModule, wcModulePath, _countof(wcModulePath) - 3); // Minus max required space for extension
-	PathRenameExtensionW(wcModulePath, L".ini");
+	GetModulePathWithExtension(wcModulePath, L".ini");
 
 	auto convFOV = [](const wchar_t* buf) -> double {
 		double userFOV = std::clamp(_wtof(buf), 30.0, 150.0);
@@ -423,14 +1229,26 @@ static void ReadINI(uint16_t* pMirror, bool* pHookMetricImperial, bool* pForcedM
 	GameMenuScale = _wtof(buffer) / 480.0;
 
 	GetPrivateProfileString(L"SilentPatch", L"ExteriorFOV", L"70.0", buffer, _countof(buffer), wcModulePath);
-	WidescreenFix::FOVNormalMult = convFOV(buffer);
+	const double exteriorFOVMult = convFOV(buffer);
 
 	GetPrivateProfileString(L"SilentPatch", L"InteriorFOV", L"70.0", buffer, _countof(buffer), wcModulePath);
-	WidescreenFix::FOVDashboardMult = convFOV(buffer);
+	const double interiorFOVMult = convFOV(buffer);
+
+	WidescreenFix::SetFOVMultipliers(exteriorFOVMult, interiorFOVMult);
 
 	ShowSteeringWheel = GetPrivateProfileInt(L"SilentPatch", L"ShowSteeringWheel", TRUE, wcModulePath) != FALSE;
 	ShowArms = GetPrivateProfileInt(L"SilentPatch", L"ShowArms", TRUE, wcModulePath) != FALSE;
 	FullRangeSteeringAnims = GetPrivateProfileInt(L"SilentPatch", L"FullRangeSteeringAnims", FALSE, wcModulePath) != FALSE;
+	IdleWhenInactive = GetPrivateProfileInt(L"SilentPatch", L"IdleWhenInactive", TRUE, wcModulePath) != FALSE;
+	FastExit = GetPrivateProfileInt(L"SilentPatch", L"FastExit", FALSE, wcModulePath) != FALSE;
+	PrefetchCarFiles = GetPrivateProfileInt(L"SilentPatch", L"PrefetchCarFiles", FALSE, wcModulePath) != FALSE;
+
+	// Extra wildcards relative to the game directory, separated with semicolons - {car} gets replaced with the car ID
+	{
+		wchar_t pathsBuffer[1024];
+		GetPrivateProfileString(L"SilentPatch", L"PrefetchPaths", L"", pathsBuffer, _countof(pathsBuffer), wcModulePath);
+		PrefetchPaths = pathsBuffer;
+	}
 
 	if (pMirror)
 	{
@@ -440,6 +1258,10 @@ static void ReadINI(uint16_t* pMirror, bool* pHookMetricImperial, bool* pForcedM
 		res = 1 << static_cast<uint32_t>(std::floor(std::log2(res)));
 	
 		*pMirror = static_cast<uint16_t>(res);
+
+		// 0 - fixed mirror resolution, otherwise lower it when frames take longer than this many milliseconds
+		GetPrivateProfileString(L"SilentPatch", L"MirrorFrameBudget", L"0.0", buffer, _countof(buffer), wcModulePath);
+		MirrorFrameBudget = std::max(0.0, _wtof(buffer));
 	}
 
 	{
@@ -461,13 +1283,324 @@ static void ReadINI(uint16_t* pMirror, bool* pHookMetricImperial, bool* pForcedM
 		}
 	}
 
-	if (pForcedMirrors)
+	if (pForcedMirrors)
+	{
+		*pForcedMirrors = GetPrivateProfileInt(L"SilentPatch", L"ForceInteriorMirrors", -1, wcModulePath) != FALSE;
+	}
+
+	if (pLiveStats)
+	{
+		*pLiveStats = GetPrivateProfileInt(L"SilentPatch", L"LiveStats", FALSE, wcModulePath) != FALSE;
+		DirectDrawStats = GetPrivateProfileInt(L"SilentPatch", L"DirectDrawStats", FALSE, wcModulePath) != FALSE;
+		AllocStats = GetPrivateProfileInt(L"SilentPatch", L"AllocStats", FALSE, wcModulePath) != FALSE;
+	}
+}
+
+// Runs fixes one after another across game launches, disabling a different one each time,
+// so their cost can be compared against the run with all fixes enabled
+namespace Benchmark
+{
+	// Every run disables the next feature from this list, followed by a baseline run with nothing disabled.
+	// Timers and WindowProc are left out - frames are sampled from the former and results written from the latter
+	static constexpr const wchar_t* FEATURE_ROTATION[] = {
+		L"ResolutionList", L"Widescreen", L"HUDScale", L"PauseMenuScale", L"PreRaceMenuScale", L"LoadingScreenScale",
+		L"NoCDCheck", L"DynamicAllocList", L"DynamicPalettesList", L"DecalsCrashFix", L"ForcedMirrors",
+		L"FullRangeSteeringAnim", L"WheelArmsToggle", L"MirrorQuality", L"PostRaceScale", L"MetricSwitch", L"LongerUserNames",
+	};
+
+	static bool enabled = false;
+	static std::wstring disabledFeature; // Empty for the baseline run
+	static std::vector<float> frameTimes;
+
+	static constexpr size_t MAX_FRAME_SAMPLES = 1024 * 1024;
+
+	void Initialize()
+	{
+		wchar_t wcModulePath[MAX_PATH];
+		GetModulePathWithExtension(wcModulePath, L".ini");
+
+		enabled = GetPrivateProfileInt(L"Benchmark", L"Enabled", FALSE, wcModulePath) != FALSE;
+		if (enabled)
+		{
+			wchar_t buffer[64];
+			GetPrivateProfileString(L"Benchmark", L"NextRun", L"", buffer, _countof(buffer), wcModulePath);
+
+			// Schedule the next run right away, so a run that crashes or never exits cleanly doesn't stall the rotation
+			const wchar_t* nextRun = FEATURE_ROTATION[0];
+			for (size_t i = 0; i < std::size(FEATURE_ROTATION); i++)
+			{
+				if (_wcsicmp(FEATURE_ROTATION[i], buffer) == 0)
+				{
+					disabledFeature = FEATURE_ROTATION[i];
+					nextRun = i + 1 < std::size(FEATURE_ROTATION) ? FEATURE_ROTATION[i + 1] : L"";
+					break;
+				}
+			}
+			WritePrivateProfileString(L"Benchmark", L"NextRun", nextRun, wcModulePath);
+
+			frameTimes.reserve(60 * 60 * 10);
+		}
+	}
+
+	bool IsFeatureDisabledThisRun(const wchar_t* id)
+	{
+		return enabled && !disabledFeature.empty() && _wcsicmp(disabledFeature.c_str(), id) == 0;
+	}
+
+	// Menus and loading screens would only dilute the differences, so only frames rendering a race are recorded.
+	// Those have the race roster set up and go through the game's 3D viewport setup - unless that's not hooked this run
+	static bool IsRaceFrame()
+	{
+		const bool viewportSet = std::exchange(WidescreenFix::viewportSetThisFrame, false);
+		if (DecalsCrashFix::gCarsInRaceDetails == nullptr || *DecalsCrashFix::gCarsInRaceDetails == nullptr)
+		{
+			return false;
+		}
+		return viewportSet || !WidescreenFix::viewportHooked;
+	}
+
+	void OnNewFrame()
+	{
+		// Alt-tabbed frames include the idle sleeps
+		if (enabled && IsRaceFrame() && !Timers::windowInactive && *m_isWindowActive && frameTimes.size() < MAX_FRAME_SAMPLES)
+		{
+			frameTimes.push_back(static_cast<float>(Timers::lastFrameTime));
+		}
+	}
+
+	// Appends the results to SilentPatchTOCA2.bench.csv
+	void Finish()
+	{
+		if (!enabled) return;
+		enabled = false;
+
+		if (frameTimes.empty()) return;
+
+		wchar_t wcModulePath[MAX_PATH];
+		GetModulePathWithExtension(wcModulePath, L".ini");
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		double sum = 0.0;
+		for (float time : frameTimes)
+		{
+			sum += time;
+		}
+		const double average = sum / frameTimes.size();
+		auto percentile = [](double p) {
+			return frameTimes[std::min(frameTimes.size() - 1, static_cast<size_t>(frameTimes.size() * p))];
+		};
+
+		wchar_t buffer[32];
+		if (disabledFeature.empty())
+		{
+			swprintf_s(buffer, L"%.4f", average);
+			WritePrivateProfileString(L"Benchmark", L"BaselineFrameTime", buffer, wcModulePath);
+		}
+		GetPrivateProfileString(L"Benchmark", L"BaselineFrameTime", L"0.0", buffer, _countof(buffer), wcModulePath);
+		const double baseline = _wtof(buffer);
+
+		wchar_t wcResultsPath[MAX_PATH];
+		GetModulePathWithExtension(wcResultsPath, L".bench.csv");
+
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, wcResultsPath, L"a+") == 0 && file != nullptr)
+		{
+			fseek(file, 0, SEEK_END);
+			if (ftell(file) == 0)
+			{
+				fputws(L"disabled,frames,avg_ms,p50_ms,p95_ms,p99_ms,delta_vs_baseline_ms\n", file);
+			}
+			fwprintf(file, L"%s,%zu,%.4f,%.4f,%.4f,%.4f,%.4f\n", disabledFeature.empty() ? L"none" : disabledFeature.c_str(), frameTimes.size(),
+				average, percentile(0.5), percentile(0.95), percentile(0.99), baseline > 0.0 ? average - baseline : 0.0);
+			fclose(file);
+		}
+	}
+}
+
+// Every fix is registered as a feature, which can be turned off in the [Features] section of the INI
+namespace Features
+{
+	enum class Status
+	{
+		Installed,
+		Resolved, // Deferred, found but not applied yet
+		Failed, // Patterns not found
+		Disabled,
+	};
+
+	struct Feature
+	{
+		const wchar_t* id;
+		Status status;
+		uint32_t installMicroseconds;
+	};
+
+	static std::mutex featuresMutex;
+	static std::vector<Feature> features;
+	static std::vector<std::wstring> disabledFeatures; // Read once, before any feature installs
+
+	static constexpr const wchar_t* STATUS_NAMES[] = { L"installed", L"resolved", L"failed", L"disabled" };
+
+	void Initialize()
+	{
+		wchar_t wcModulePath[MAX_PATH];
+		GetModulePathWithExtension(wcModulePath, L".ini");
+
+		// Pairs of id=value, each null terminated, with an extra null terminator at the end
+		std::vector<wchar_t> buffer(32767);
+		GetPrivateProfileSection(L"Features", buffer.data(), static_cast<DWORD>(buffer.size()), wcModulePath);
+		for (const wchar_t* entry = buffer.data(); *entry != L'\0'; entry += wcslen(entry) + 1)
+		{
+			const wchar_t* separator = wcschr(entry, L'=');
+			if (separator != nullptr && _wtoi(separator + 1) == 0)
+			{
+				disabledFeatures.emplace_back(entry, separator);
+			}
+		}
+	}
+
+	static bool IsDisabled(const wchar_t* id)
+	{
+		for (const std::wstring& disabled : disabledFeatures)
+		{
+			if (_wcsicmp(disabled.c_str(), id) == 0) return true;
+		}
+		return Benchmark::IsFeatureDisabledThisRun(id);
+	}
+
+	static void RegisterFeature(const wchar_t* id, Status status, uint32_t installMicroseconds)
+	{
+		wchar_t buffer[128];
+		swprintf_s(buffer, L"SilentPatch: %s %s (%u us)\n", id, STATUS_NAMES[static_cast<size_t>(status)], installMicroseconds);
+		OutputDebugStringW(buffer);
+
+		std::lock_guard<std::mutex> lock(featuresMutex);
+		features.push_back({ id, status, installMicroseconds });
+	}
+
+	template<typename Func>
+	static bool InstallWithStatus(const wchar_t* id, Func&& func, Status successStatus)
+	{
+		if (IsDisabled(id))
+		{
+			RegisterFeature(id, Status::Disabled, 0);
+			return false;
+		}
+
+		LARGE_INTEGER startTime, endTime, frequency;
+		QueryPerformanceCounter(&startTime);
+
+		bool installed = false;
+		try
+		{
+			func();
+			installed = true;
+		}
+		TXN_CATCH();
+
+		QueryPerformanceCounter(&endTime);
+		QueryPerformanceFrequency(&frequency);
+		RegisterFeature(id, installed ? successStatus : Status::Failed, static_cast<uint32_t>((endTime.QuadPart - startTime.QuadPart) * 1000000 / frequency.QuadPart));
+		return installed;
+	}
+
+	// Installs the fix unless it's disabled, returns true if it installed successfully
+	template<typename Func>
+	bool Install(const wchar_t* id, Func&& func)
+	{
+		return InstallWithStatus(id, std::forward<Func>(func), Status::Installed);
+	}
+
+	// Resolves a deferred fix unless it's disabled - func returns the patches to apply later from the game thread,
+	// and the feature only counts as installed once they are
+	template<typename Func>
+	bool Resolve(const wchar_t* id, Func&& func)
+	{
+		return InstallWithStatus(id, [&] { DeferredHooks::resolvedPatches.emplace_back(id, func()); }, Status::Resolved);
+	}
+
+	void MarkApplied(const wchar_t* id)
+	{
+		{
+			std::lock_guard<std::mutex> lock(featuresMutex);
+			for (Feature& feature : features)
+			{
+				if (feature.id == id) feature.status = Status::Installed;
+			}
+		}
+
+		wchar_t buffer[128];
+		swprintf_s(buffer, L"SilentPatch: %s %s\n", id, STATUS_NAMES[static_cast<size_t>(Status::Installed)]);
+		OutputDebugStringW(buffer);
+	}
+}
+
+// Measures the time from the window being destroyed to the palettes being released, and to the process exiting
+namespace ExitTimer
+{
+	static int64_t exitStartTime = 0;
+	static bool saved = false;
+
+	static void Save();
+
+	// Detached palettes are only freed by DirectDraw itself once the game releases it, so the exit time is taken there -
+	// still a part of the game's own teardown, outside of the loader lock
+	static constexpr size_t VTBL_RELEASE = 2;
+	static ULONG (STDMETHODCALLTYPE* orgRelease)(IDirectDraw* self);
+	static ULONG STDMETHODCALLTYPE Release_SaveOnLast(IDirectDraw* self)
+	{
+		const ULONG refCount = orgRelease(self);
+		if (refCount == 0)
+		{
+			Save();
+		}
+		return refCount;
+	}
+
+	void Start()
+	{
+		LARGE_INTEGER time;
+		QueryPerformanceCounter(&time);
+		exitStartTime = time.QuadPart;
+
+		if (g_pDirectDraw != nullptr && *g_pDirectDraw != nullptr)
+		{
+			DirectDrawCallStats::PatchVTable(*g_pDirectDraw, VTBL_RELEASE, Release_SaveOnLast, orgRelease);
+		}
+	}
+
+	static double GetElapsedMS()
+	{
+		LARGE_INTEGER time, frequency;
+		QueryPerformanceCounter(&time);
+		QueryPerformanceFrequency(&frequency);
+		return static_cast<double>(time.QuadPart - exitStartTime) * 1000.0 / frequency.QuadPart;
+	}
+
+	static void Save()
+	{
+		if (exitStartTime == 0 || saved) return;
+		saved = true;
+
+		wchar_t wcModulePath[MAX_PATH];
+		GetModulePathWithExtension(wcModulePath, L".ini");
+
+		wchar_t buffer[32];
+		swprintf_s(buffer, L"%.2f", GetElapsedMS());
+		WritePrivateProfileString(L"Stats", FastExit ? L"LastFastExitTime" : L"LastExitTime", buffer, wcModulePath);
+	}
+
+	// Called from DllMain, so debug output only
+	void Report()
 	{
-		*pForcedMirrors = GetPrivateProfileInt(L"SilentPatch", L"ForceInteriorMirrors", -1, wcModulePath) != FALSE;
+		if (exitStartTime == 0) return;
+
+		wchar_t buffer[64];
+		swprintf_s(buffer, L"SilentPatch: Exiting took %.2f ms (FastExit=%d)\n", GetElapsedMS(), FastExit ? 1 : 0);
+		OutputDebugStringW(buffer);
 	}
 }
 
-static BOOL* bRequestsExit;
 static LRESULT (CALLBACK* orgWindowProc)(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
@@ -477,14 +1610,31 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 		return DefWindowProcA(hwnd, uMsg, wParam, lParam);
 
 	case WM_DESTROY:
+		// Flush everything that has to persist before the game starts tearing down
+		ExitTimer::Start();
+		Benchmark::Finish();
 		*bRequestsExit = TRUE;
 		PostQuitMessage(0);
 		return 0;
 	
 	case WM_ACTIVATE:
-		if (wParam != WA_INACTIVE)
+		if (LOWORD(wParam) != WA_INACTIVE)
+		{
+			ReadINI(nullptr, nullptr, nullptr, nullptr);
+			SurfaceInspector::RequestInspection();
+			DynamicAllocList::OnRestore();
+		}
+		Timers::SetWindowInactive(LOWORD(wParam) == WA_INACTIVE || HIWORD(wParam) != 0);
+		break;
+
+	case WM_SIZE:
+		if (wParam == SIZE_MINIMIZED)
 		{
-			ReadINI(nullptr, nullptr, nullptr);
+			Timers::SetWindowInactive(true);
+		}
+		else if (wParam == SIZE_RESTORED || wParam == SIZE_MAXIMIZED)
+		{
+			Timers::SetWindowInactive(GetForegroundWindow() != hwnd);
 		}
 		break;
 
@@ -557,16 +1707,53 @@ namespace WheelArmsToggle
 
 namespace MirrorQuality
 {
+	static MirrorGovernor governor;
+	static uint16_t* mirrorSurfaceSize;
+	static uint16_t activeMirrorRes = 64;
+
+	// The mirror surface and viewport must always agree on the size,
+	// so a resolution picked by the governor only takes effect when the mirror is recreated
 	void (__stdcall* orgCreateViewport)(void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height, float multX, float multY);
 	void __stdcall CreateViewport_InCarMirrorScale(void* data, uint32_t x, uint32_t y, uint32_t /*width*/, uint32_t /*height*/, float multX, float multY)
 	{
-		orgCreateViewport(data, x, y, InCarMirrorRes, InCarMirrorRes / 2, multX, multY);
+		activeMirrorRes = governor.IsEnabled() ? governor.GetResolution() : InCarMirrorRes;
+		if (mirrorSurfaceSize != nullptr)
+		{
+			*mirrorSurfaceSize = activeMirrorRes;
+		}
+		orgCreateViewport(data, x, y, activeMirrorRes, activeMirrorRes / 2, multX, multY);
+		governor.OnResolutionApplied(activeMirrorRes);
+
+		// The mirror gets created when a race loads
+		SurfaceInspector::RequestInspection();
 	}
 
+	uint32_t (__stdcall* GetCurrentCamera)(int camID);
+
+	// When the mirror is not due for an update or not visible from the current camera, the mirror pass is squeezed into
+	// its top left pixel, so it clears and rasterizes next to nothing and the rest of the mirror keeps its previous contents.
+	// The scene is still traversed, as the mirror draw itself is not hooked.
+	// Not a zero sized viewport - the game derives its projection from the viewport size
 	void (__stdcall* orgSetViewportBounds)(void* data, const uint16_t rect1[4], const uint16_t rect2[4]);
 	void __stdcall SetViewportBounds_InCarMirror(void* data, const uint16_t* /*rect1*/, const uint16_t* /*rect2*/)
 	{
-		const uint16_t rect[] = { 0, 0, InCarMirrorRes, static_cast<uint16_t>(InCarMirrorRes / 2) };
+		// Frames from cameras the mirror can't be seen from say nothing about its cost, so the governor never sees them
+		bool visible = true;
+		if (governor.IsEnabled() && GetCurrentCamera != nullptr)
+		{
+			const uint32_t camID = GetCurrentCamera(0);
+			visible = camID == 2 || camID == 4;
+		}
+
+		bool render = false;
+		if (visible)
+		{
+			governor.AddFrameTime(Timers::lastFrameTime);
+			render = governor.ShouldRenderFrame();
+		}
+
+		const uint16_t size = render ? activeMirrorRes : 1;
+		const uint16_t rect[] = { 0, 0, size, static_cast<uint16_t>(render ? size / 2 : 1) };
 		orgSetViewportBounds(data, rect, rect);
 	}
 }
@@ -619,29 +1806,337 @@ namespace LongerUserNames
 	}
 }
 
+namespace Signatures
+{
+	using SectionRange = std::pair<const uint8_t*, const uint8_t*>;
+
+	// Signatures only ever point at code, so unlike get_pattern scanning the entire image,
+	// only the sections marked as code or executable are scanned
+	static std::vector<SectionRange> ReadExecutableSections()
+	{
+		std::vector<SectionRange> sections;
+
+		const auto* module = reinterpret_cast<const uint8_t*>(GetModuleHandle(nullptr));
+		const auto* dosHeader = reinterpret_cast<const IMAGE_DOS_HEADER*>(module);
+		const auto* ntHeader = reinterpret_cast<const IMAGE_NT_HEADERS*>(module + dosHeader->e_lfanew);
+
+		const IMAGE_SECTION_HEADER* section = IMAGE_FIRST_SECTION(ntHeader);
+		for (WORD i = 0; i < ntHeader->FileHeader.NumberOfSections; i++, section++)
+		{
+			if ((section->Characteristics & (IMAGE_SCN_MEM_EXECUTE|IMAGE_SCN_CNT_CODE)) != 0)
+			{
+				const uint8_t* begin = module + section->VirtualAddress;
+				sections.emplace_back(begin, begin + section->Misc.VirtualSize);
+			}
+		}
+		return sections;
+	}
+
+	// First called from OnInitializeHook, before the deferred hooks thread starts
+	static const std::vector<SectionRange>& GetExecutableSections()
+	{
+		static const std::vector<SectionRange> sections = ReadExecutableSections();
+		return sections;
+	}
+
+	static std::vector<const uint8_t*> FindAll(const SignatureView& sig, size_t maxResults)
+	{
+		std::vector<const uint8_t*> results;
+		for (const SectionRange& section : GetExecutableSections())
+		{
+			Scan(sig, section.first, section.second, results, maxResults);
+		}
+		return results;
+	}
+
+	// Equivalent of hook::pattern_match, for signatures referenced at several offsets
+	struct Match
+	{
+		uint8_t* address;
+
+		template<typename T = void>
+		T* get(ptrdiff_t offset = 0) const
+		{
+			return reinterpret_cast<T*>(address + offset);
+		}
+	};
+
+	// Equivalent of get_pattern for compiled signatures, throws if the signature is not unique
+	template<typename T = void, size_t N>
+	auto get_signature(const Signature<N>& sig, ptrdiff_t offset = 0)
+	{
+		const std::vector<const uint8_t*> results = FindAll(sig.view(), 2);
+		if (results.size() != 1)
+		{
+			throw hook::txn_exception();
+		}
+		return reinterpret_cast<T*>(const_cast<uint8_t*>(results[0]) + offset);
+	}
+
+	// Equivalent of pattern().get_one()
+	template<size_t N>
+	Match get_signature_match(const Signature<N>& sig)
+	{
+		return { get_signature<uint8_t>(sig) };
+	}
+
+	// Equivalent of pattern().count(expectedCount), or pattern().count_hint() if expectedCount is 0
+	template<size_t N>
+	std::vector<Match> get_signatures(const Signature<N>& sig, size_t expectedCount = 0)
+	{
+		const std::vector<const uint8_t*> results = FindAll(sig.view(), expectedCount != 0 ? expectedCount + 1 : SIZE_MAX);
+		if (expectedCount != 0 && results.size() != expectedCount)
+		{
+			throw hook::txn_exception();
+		}
+
+		std::vector<Match> matches;
+		matches.reserve(results.size());
+		for (const uint8_t* result : results)
+		{
+			matches.push_back({ const_cast<uint8_t*>(result) });
+		}
+		return matches;
+	}
+}
+
+namespace DeferredHooks
+{
+	static bool hookUnits;
+
+	// Runs on a worker thread - only pattern scans and reads are allowed here,
+	// all writes to the game code are returned as patches to apply from the game thread
+	static void ResolveDeferredHooks()
+	{
+		using namespace Memory;
+		using namespace Signatures;
+
+		// Fixed and customizable post-race screen scale
+		Features::Resolve(L"PostRaceScale", [&]
+		{
+			auto res_x_check = get_signature_match(SIGNATURE("A1 ? ? ? ? 3D 00 04 00 00 76 1A"));
+			auto res_y_check = get_signature_match(SIGNATURE("A1 ? ? ? ? 3D 00 03 00 00 76 1A"));
+
+			std::vector<void*> scale_values;
+			for (const Match& match : get_signatures(SIGNATURE("DF 6C 24 18 DC 0D ? ? ? ? D9 1D ? ? ? ? EB 2B"), 2))
+			{
+				scale_values.push_back(match.get<void>(4 + 2));
+			}
+
+			return [res_x_check, res_y_check, scale_values]
+			{
+				Patch(res_x_check.get<int*>(1), *res_y_check.get<int*>(1)); // Res scale X -> Res scale Y
+				Nop(res_x_check.get<void>(5 + 5), 2); // Scale X unconditionally
+				Nop(res_y_check.get<void>(5 + 5), 2); // Scale Y unconditionally
+
+				for (void* addr : scale_values)
+				{
+					Patch(addr, &GameMenuScale);
+				}
+			};
+		});
+
+		// Metric/imperial switch
+		if (hookUnits)
+		{
+			Features::Resolve(L"MetricSwitch", [&]
+			{
+				using namespace MetricSwitch;
+
+				std::vector<void*> addresses = {
+					get_signature(SIGNATURE("8B EC A1 ? ? ? ? 8B 90"), 2 + 1), // Distance unit conversion
+					get_signature(SIGNATURE("83 EC 08 A1 ? ? ? ? 53 56"), 3 + 1),
+					get_signature(SIGNATURE("89 43 EC A1"), 3 + 1),
+				};
+
+				auto get_distance_unit_string = get_signature_match(SIGNATURE("A1 ? ? ? ? 8B 88 ? ? ? ? B8"));
+				auto prepare_ui_data = get_signatures(SIGNATURE("A1 ? ? ? ? 8B 88 ? ? ? ? 85 C9 75 1C A1")); // 2 in 4.1, 1 in 1.0
+				auto prepare_ui_data_10_only = get_signatures(SIGNATURE("39 9A ? ? ? ? 75 1C")); // 1.0 only, in 4.1 it shares the above pattern
+
+				fakeGamePtrForMetric = reinterpret_cast<char*>(&UseMetric) - *get_distance_unit_string.get<uint32_t>(5 + 2);
+
+				addresses.push_back(get_distance_unit_string.get<void>(1));
+				for (const Match& match : prepare_ui_data)
+				{
+					addresses.push_back(match.get<void>(1));
+				}
+				for (const Match& match : prepare_ui_data_10_only)
+				{
+					addresses.push_back(match.get<void>(1));
+				}
+
+				return [addresses]
+				{
+					for (void* addr : addresses)
+					{
+						Patch(addr, &fakeGamePtrForMetric);
+					}
+				};
+			});
+		}
+
+		// Allow for more characters in names (and for longer names)
+		Features::Resolve(L"LongerUserNames", [&]
+		{
+			using namespace LongerUserNames;
+
+			auto is_legal_name_char = get_signature(SIGNATURE("85 C0 75 09 83 FB 08 0F 85 ? ? ? ? A1 ? ? ? ? 33 C9"), -5);
+			auto get_typed_key = get_signature(SIGNATURE("66 89 44 24 ? E8 ? ? ? ? E8 ? ? ? ? 8B D8"), 5 + 5);
+			auto max_name_length = get_signature(SIGNATURE("83 F8 ? 7D 4D"), 2);
+			auto get_decal_width = get_signature(SIGNATURE("F3 A4 E8 ? ? ? ? 33 C9 3D"), 2);
+
+			std::array<void*, 3> init_decals = {
+				get_signature(SIGNATURE("50 53 E8 ? ? ? ? E9"), 2),
+				get_signature(SIGNATURE("E8 ? ? ? ? E9 ? ? ? ? 83 FF FF")),
+				get_signature(SIGNATURE("E8 ? ? ? ? 8B 6C 24 10 33 C9")),
+			};
+
+			ReadCall(get_typed_key, orgGetTypedKey);
+			ReadCall(init_decals[0], orgInitializeWindshieldDecal);
+			ReadCall(get_decal_width, orgGetTextWidth);
+
+			return [is_legal_name_char, get_typed_key, max_name_length, get_decal_width, init_decals]
+			{
+				InjectHook(is_legal_name_char, IsLegalCharForName);
+				InjectHook(get_typed_key, GetTypedKey_ConvertToChar);
+				for (void* addr : init_decals)
+				{
+					InjectHook(addr, InitializeWindshieldDecal_SkipDot);
+				}
+
+				Patch<uint8_t>(max_name_length, 15);
+
+				InjectHook(get_decal_width, GetTextWidth_ExtractLastName);
+			};
+		});
+	}
+
+	static DWORD WINAPI ResolveThread(LPVOID)
+	{
+		ResolveDeferredHooks();
+		patchesResolved.store(true, std::memory_order_release);
+		return 0;
+	}
+
+	// If the timers hook (our patch barrier) didn't install, resolve and apply synchronously
+	void Start(bool units, bool barrierInstalled)
+	{
+		hookUnits = units;
+		if (barrierInstalled)
+		{
+			hResolveThread = CreateThread(nullptr, 0, ResolveThread, nullptr, 0, nullptr);
+			if (hResolveThread != nullptr)
+			{
+				return;
+			}
+		}
+
+		ResolveDeferredHooks();
+		ApplyPatches();
+	}
+}
+
+namespace LiveStatsPage
+{
+	static LiveStats::Page* page;
+	static double averageFrameTime;
+
+	void Create()
+	{
+		wchar_t sectionName[64];
+		swprintf_s(sectionName, LiveStats::SECTION_NAME_FORMAT, GetCurrentProcessId());
+
+		HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(LiveStats::Page), sectionName);
+		if (mapping != nullptr)
+		{
+			// The mapping handle is intentionally kept open for the lifetime of the process
+			void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, sizeof(LiveStats::Page));
+			if (view != nullptr)
+			{
+				page = new(view) LiveStats::Page;
+				LiveStats::InitializePage(page);
+			}
+		}
+	}
+
+	void Publish()
+	{
+		if (page == nullptr) return;
+
+		averageFrameTime += (Timers::lastFrameTime - averageFrameTime) * 0.05;
+
+		LiveStats::Data data {};
+		data.fps = averageFrameTime > 0.0 ? static_cast<float>(1000.0 / averageFrameTime) : 0.0f;
+		data.frameTime = static_cast<float>(Timers::lastFrameTime);
+		data.allocListCapacity = static_cast<uint32_t>(DynamicAllocList::allocList.GetCapacity());
+		data.allocListLiveCount = DynamicAllocList::m_currentAllocSize != nullptr ? *DynamicAllocList::m_currentAllocSize : 0;
+		data.numPalettes = static_cast<uint32_t>(DynamicPalettesList::createdPalettes.size());
+		data.numResolutions = static_cast<uint32_t>(ResolutionList::resolutionsList.size());
+		if (m_currentRes != nullptr)
+		{
+			data.currentResWidth = m_currentRes->width;
+			data.currentResHeight = m_currentRes->height;
+		}
+		data.currentCamera = static_cast<int32_t>(WidescreenFix::currentCamera);
+		data.configEpoch = ConfigEpoch;
+		data.surfaceMemory = SurfaceInspector::lastResults;
+		std::copy(std::begin(SurfaceInspector::lastFormats), std::end(SurfaceInspector::lastFormats), std::begin(data.surfaceFormats));
+		data.allocHistogram = DynamicAllocList::GetHistogram();
+		data.restoreAllocations = DynamicAllocList::GetRestoreStats();
+		data.loadTimes = DecalsCrashFix::GetLoadTimes();
+		data.directDrawFrame = DirectDrawCallStats::lastFrame;
+
+		LiveStats::Write(page, data);
+	}
+}
+
+static void OnNewFrame()
+{
+	DeferredHooks::ApplyResolvedPatches();
+	DirectDrawCallStats::OnNewFrame();
+	SurfaceInspector::OnNewFrame();
+	DecalsCrashFix::OnNewFrame();
+	LiveStatsPage::Publish();
+	Benchmark::OnNewFrame();
+}
+
 void OnInitializeHook()
 {
-	bool hookUnits = false, forcedMirrors = false;
-	ReadINI(&InCarMirrorRes, &hookUnits, &forcedMirrors);
+	bool hookUnits = false, forcedMirrors = false, liveStats = false, timersHooked = false;
+	ReadINI(&InCarMirrorRes, &hookUnits, &forcedMirrors, &liveStats);
+
+	if (liveStats)
+	{
+		LiveStatsPage::Create();
+	}
+	Benchmark::Initialize();
+	Features::Initialize();
 
 	std::unique_ptr<ScopedUnprotect::Unprotect> Protect = ScopedUnprotect::UnprotectSectionOrFullModule( GetModuleHandle( nullptr ), ".text" );
 
 	using namespace Memory;
-	using namespace hook::txn;
+	using namespace Signatures;
+
+	// Not a fix on its own - the race roster is used by the decals fixes, the prefetch and the benchmark
+	try
+	{
+		DecalsCrashFix::gCarsInRaceDetails = *get_signature<DecalsCrashFix::CarDetails**>(SIGNATURE("8B 0D ? ? ? ? 8A 44 01 10"), 2);
+	}
+	TXN_CATCH();
 
 	// Timers rewritten for accuracy
 	// Not locking up on modern CPUs, counting time backwards
-	try
+	timersHooked = Features::Install(L"Timers", [&]
 	{
 		using namespace Timers;
 
-		auto init_timers = get_pattern("83 EC 08 8D 44 24 00 50 FF 15 ? ? ? ? 8D 54 24 00");
-		auto tick_timers = get_pattern("50 FF 15 ? ? ? ? A1 ? ? ? ? 85 C0", -7);
-		auto wait_timer = get_pattern("53 56 57 50 33 FF FF 15 ? ? ? ?", -7);
+		auto init_timers = get_signature(SIGNATURE("83 EC 08 8D 44 24 00 50 FF 15 ? ? ? ? 8D 54 24 00"));
+		auto tick_timers = get_signature(SIGNATURE("50 FF 15 ? ? ? ? A1 ? ? ? ? 85 C0"), -7);
+		auto wait_timer = get_signature(SIGNATURE("53 56 57 50 33 FF FF 15 ? ? ? ?"), -7);
 
-		bool* isWindowActive = *get_pattern<bool*>("A1 ? ? ? ? 85 C0 75 04 33 C0", 1);
-		int* lastTick = *get_pattern<int*>("A3 ? ? ? ? EB 3A", 1);
-		int* currentTime = *get_pattern<int*>("8B 0D ? ? ? ? 8B 54 24 00", 2);
+		bool* isWindowActive = *get_signature<bool*>(SIGNATURE("A1 ? ? ? ? 85 C0 75 04 33 C0"), 1);
+		int* lastTick = *get_signature<int*>(SIGNATURE("A3 ? ? ? ? EB 3A"), 1);
+		int* currentTime = *get_signature<int*>(SIGNATURE("8B 0D ? ? ? ? 8B 54 24 00"), 2);
 
 		m_isWindowActive = isWindowActive;
 		m_lastTick = lastTick;
@@ -650,22 +2145,21 @@ void OnInitializeHook()
 		InjectHook(init_timers, InitTimers, PATCH_JUMP);
 		InjectHook(tick_timers, TickTimers, PATCH_JUMP);
 		InjectHook(wait_timer, WaitTimer, PATCH_JUMP);
-	}
-	TXN_CATCH();
+	});
 
 	// Unlimited resolutions list + allowed for all resolutions
 	// Filtering out resolutions under 640x480
-	try
+	Features::Install(L"ResolutionList", [&]
 	{
 		using namespace ResolutionList;
 
-		auto on_enum_resolution = get_pattern("68 ? ? ? ? 6A 00 6A 00 8B 08 6A 01", 1);
-		auto res_exists = get_pattern("33 C9 56 85 D2", -6);
-		auto try_set_previous_res = get_pattern("53 33 DB 33 C0", -6);
-		auto get_packed_res = get_pattern("C1 E0 02 66 8B 88", -7);
-		auto get_num_resolutions_ptr = get_pattern("E8 ? ? ? ? 68 ? ? ? ? 8B E8");
+		auto on_enum_resolution = get_signature(SIGNATURE("68 ? ? ? ? 6A 00 6A 00 8B 08 6A 01"), 1);
+		auto res_exists = get_signature(SIGNATURE("33 C9 56 85 D2"), -6);
+		auto try_set_previous_res = get_signature(SIGNATURE("53 33 DB 33 C0"), -6);
+		auto get_packed_res = get_signature(SIGNATURE("C1 E0 02 66 8B 88"), -7);
+		auto get_num_resolutions_ptr = get_signature(SIGNATURE("E8 ? ? ? ? 68 ? ? ? ? 8B E8"));
 
-		auto current_resx = *get_pattern<decltype(m_currentRes)>("8B 3D ? ? ? ? B8 ? ? ? ? 3B 78 FC", 2);
+		auto current_resx = *get_signature<decltype(m_currentRes)>(SIGNATURE("8B 3D ? ? ? ? B8 ? ? ? ? 3B 78 FC"), 2);
 
 		m_currentRes = current_resx;
 
@@ -677,17 +2171,16 @@ void OnInitializeHook()
 		void* get_num_resolutions;
 		ReadCall(get_num_resolutions_ptr, get_num_resolutions);
 		InjectHook(get_num_resolutions, GetNumResolutions, PATCH_JUMP);
-	}
-	TXN_CATCH();
+	});
 
 	// Arbitrary aspect ratio and FOV support
-	try
+	Features::Install(L"Widescreen", [&]
 	{
 		using namespace WidescreenFix;
 
-		auto set_viewport = pattern("DB 44 24 08 DB 44 24 0C D9 C2").get_one();
-		auto calculate_fov = pattern("D8 74 24 00 D9 44 24 0C").get_one();
-		auto get_current_camera_ptr = get_pattern("E8 ? ? ? ? 83 F8 04 75 1A");
+		auto set_viewport = get_signature_match(SIGNATURE("DB 44 24 08 DB 44 24 0C D9 C2"));
+		auto calculate_fov = get_signature_match(SIGNATURE("D8 74 24 00 D9 44 24 0C"));
+		auto get_current_camera_ptr = get_signature(SIGNATURE("E8 ? ? ? ? 83 F8 04 75 1A"));
 
 		SetViewport_ThunkEnd = set_viewport.get<void>();
 		InjectHook(set_viewport.get<void>(-5), SetViewport_CalculateAR, PATCH_JUMP);
@@ -696,60 +2189,59 @@ void OnInitializeHook()
 		ReadCall(get_current_camera_ptr, GetCurrentCamera);
 		InjectHook(calculate_fov.get<void>(10), MultByFOV, PATCH_CALL);
 		Nop(calculate_fov.get<void>(10 + 5), 5);
-	}
-	TXN_CATCH();
+
+		viewportHooked = true;
+	});
 
 	// Fixed and customizable HUD scale
-	try
+	Features::Install(L"HUDScale", [&]
 	{
-		auto cmp_1000 = get_pattern("3D ? ? ? ? 57 76 3D", 1);
-		auto scale_values = pattern("DC 0D ? ? ? ? D9 C9 DC 0D ? ? ? ? D9 C9 D9 1D ? ? ? ? D9 1D ? ? ? ? EB 14").get_one();
-		auto res_scale_x = get_pattern<int*>("A1 ? ? ? ? 83 EC 08 53", 1);
-		auto res_scale_y = get_pattern<int*>("A1 ? ? ? ? 89 5C 24 14", 1);
+		auto cmp_1000 = get_signature(SIGNATURE("3D ? ? ? ? 57 76 3D"), 1);
+		auto scale_values = get_signature_match(SIGNATURE("DC 0D ? ? ? ? D9 C9 DC 0D ? ? ? ? D9 C9 D9 1D ? ? ? ? D9 1D ? ? ? ? EB 14"));
+		auto res_scale_x = get_signature<int*>(SIGNATURE("A1 ? ? ? ? 83 EC 08 53"), 1);
+		auto res_scale_y = get_signature<int*>(SIGNATURE("A1 ? ? ? ? 89 5C 24 14"), 1);
 
 		Patch<uint32_t>(cmp_1000, 480);
 		Patch(scale_values.get<void>(2), &HUDScale);
 		Patch(scale_values.get<void>(8 + 2), &HUDScale);
 
 		Patch(res_scale_x, *res_scale_y);
-	}
-	TXN_CATCH();
+	});
 
 	// Fixed and customizable pause menu scale
-	try
+	Features::Install(L"PauseMenuScale", [&]
 	{
-		auto ctor_res_scale_x = get_pattern<int*>("A1 ? ? ? ? 56 33 F6 89 44 24 04", 1);
-		auto ctor_res_scale_y = get_pattern<int*>("8B 0D ? ? ? ? DF 6C 24 04", 2);
+		auto ctor_res_scale_x = get_signature<int*>(SIGNATURE("A1 ? ? ? ? 56 33 F6 89 44 24 04"), 1);
+		auto ctor_res_scale_y = get_signature<int*>(SIGNATURE("8B 0D ? ? ? ? DF 6C 24 04"), 2);
 		void* scale_values[] = {
-			get_pattern("DC 0D ? ? ? ? 8B 4C 24 18", 2),
-			get_pattern("DC 0D ? ? ? ? D9 1D ? ? ? ? E8 ? ? ? ? 89 35", 2),
+			get_signature(SIGNATURE("DC 0D ? ? ? ? 8B 4C 24 18"), 2),
+			get_signature(SIGNATURE("DC 0D ? ? ? ? D9 1D ? ? ? ? E8 ? ? ? ? 89 35"), 2),
 		};
-		auto cmp_100 = pattern("BF E8 03 00 00").count(2);
+		auto cmp_100 = get_signatures(SIGNATURE("BF E8 03 00 00"), 2);
 
 		Patch(ctor_res_scale_x, *ctor_res_scale_y);
 		for (void* addr : scale_values)
 		{
 			Patch(addr, &GameMenuScale);
 		}
-		cmp_100.for_each_result([](hook::pattern_match match)
+		for (const Match& match : cmp_100)
 		{
 			Patch<uint32_t>(match.get<void>(1), 640);
-		});
-	}
-	TXN_CATCH();
+		}
+	});
 
 	// Fixed and customizable pre-race menu scale
-	try
+	Features::Install(L"PreRaceMenuScale", [&]
 	{
-		auto ctor_res_scale_x = get_pattern<int*>("A1 ? ? ? ? 83 EC 08 3D", 1);
-		auto ctor_res_scale_y = get_pattern<int*>("89 44 24 00 A1", 4 + 1);
-		auto scale_values = pattern("DF 6C 24 00 D9 C9").get_one();
+		auto ctor_res_scale_x = get_signature<int*>(SIGNATURE("A1 ? ? ? ? 83 EC 08 3D"), 1);
+		auto ctor_res_scale_y = get_signature<int*>(SIGNATURE("89 44 24 00 A1"), 4 + 1);
+		auto scale_values = get_signature_match(SIGNATURE("DF 6C 24 00 D9 C9"));
 		void* cmp_1000_y[] = {
-			get_pattern("3D ? ? ? ? 76 43", 1),
+			get_signature(SIGNATURE("3D ? ? ? ? 76 43"), 1),
 		};
 		void* cmp_1000_x[] = {
-			get_pattern("81 3D ? ? ? ? ? ? ? ? 76 29", 6),
-			get_pattern("81 3D ? ? ? ? ? ? ? ? 76 0F", 6),
+			get_signature(SIGNATURE("81 3D ? ? ? ? ? ? ? ? 76 29"), 6),
+			get_signature(SIGNATURE("81 3D ? ? ? ? ? ? ? ? 76 0F"), 6),
 		};
 
 		Patch(ctor_res_scale_x, *ctor_res_scale_y);
@@ -763,217 +2255,172 @@ void OnInitializeHook()
 		{
 			Patch<uint32_t>(addr, 640);
 		}
-	}
-	TXN_CATCH();
+	});
 
 	// Fixed and customizable loading screen text scale
-	try
+	Features::Install(L"LoadingScreenScale", [&]
 	{
-		auto ctor_res_scale_x = get_pattern<int*>("66 89 44 24 ? A1 ? ? ? ? 56", 5 + 1);
-		auto ctor_res_scale_y = get_pattern<int*>("76 30 8B 0D", 2 + 2);
-		auto cmp_1000 = get_pattern("3D ? ? ? ? 57 66 89 6C 24", 1);
-		auto scale_values = pattern("DC 0D ? ? ? ? D9 C9 DC 0D ? ? ? ? EB 0C").get_one();
+		auto ctor_res_scale_x = get_signature<int*>(SIGNATURE("66 89 44 24 ? A1 ? ? ? ? 56"), 5 + 1);
+		auto ctor_res_scale_y = get_signature<int*>(SIGNATURE("76 30 8B 0D"), 2 + 2);
+		auto cmp_1000 = get_signature(SIGNATURE("3D ? ? ? ? 57 66 89 6C 24"), 1);
+		auto scale_values = get_signature_match(SIGNATURE("DC 0D ? ? ? ? D9 C9 DC 0D ? ? ? ? EB 0C"));
 
 		Patch(ctor_res_scale_x, *ctor_res_scale_y);
 		Patch<uint32_t>(cmp_1000, 480);
 		Patch(scale_values.get<void>(2), &GameMenuScale);
 		Patch(scale_values.get<void>(8 + 2), &GameMenuScale);
-	}
-	TXN_CATCH();
-
-	// Fixed and customizable post-race screen scale
-	try
-	{
-		auto res_x_check = pattern("A1 ? ? ? ? 3D 00 04 00 00 76 1A").get_one();
-		auto res_y_check = pattern("A1 ? ? ? ? 3D 00 03 00 00 76 1A").get_one();
-		auto scales = pattern("DF 6C 24 18 DC 0D ? ? ? ? D9 1D ? ? ? ? EB 2B").count(2);
-
-		Patch(res_x_check.get<int*>(1), *res_y_check.get<int*>(1)); // Res scale X -> Res scale Y
-		Nop(res_x_check.get<void>(5 + 5), 2); // Scale X unconditionally
-		Nop(res_y_check.get<void>(5 + 5), 2); // Scale Y unconditionally
-
-		scales.for_each_result([](hook::pattern_match match)
-		{
-			Patch(match.get<void>(4 + 2), &GameMenuScale);
-		});
-	}
-	TXN_CATCH();
+	});
 
 	// Remove CD check
-	try
+	Features::Install(L"NoCDCheck", [&]
 	{
-		auto cd_check = get_pattern("F3 A4 E8 ? ? ? ? 85 DB", 9);
+		auto cd_check = get_signature(SIGNATURE("F3 A4 E8 ? ? ? ? 85 DB"), 9);
 		Nop(cd_check, 10);
-	}
-	TXN_CATCH();
+	});
 
 	// Make the (presumably?) allocation list dynamic so it doesn't overflow
 	// Fixes a crash when continuously minimizing and maximizing (+ ~50 allocations per maximize)
-	try
+	Features::Install(L"DynamicAllocList", [&]
 	{
 		using namespace DynamicAllocList;
 
-		auto alloc_size_var = *get_pattern<uint32_t*>("89 35 ? ? ? ? 89 35 ? ? ? ? A3", 2);
-		auto alloc_function = get_pattern("E8 ? ? ? ? 8B 0D ? ? ? ? 6A 00 50");
+		auto alloc_size_var = *get_signature<uint32_t*>(SIGNATURE("89 35 ? ? ? ? 89 35 ? ? ? ? A3"), 2);
+		auto alloc_function = get_signature(SIGNATURE("E8 ? ? ? ? 8B 0D ? ? ? ? 6A 00 50"));
 
 		uint32_t* alloc_sizes[] = {
-			get_pattern<uint32_t>("B9 ? ? ? ? 33 C0 BF ? ? ? ? 33 F6 F3 AB B8", 1),
+			get_signature<uint32_t>(SIGNATURE("B9 ? ? ? ? 33 C0 BF ? ? ? ? 33 F6 F3 AB B8"), 1),
 		};
 		void** allocs_begin[] = {
-			get_pattern<void*>("BF ? ? ? ? 33 F6 F3 AB B8", 1),
-			get_pattern<void*>("BE ? ? ? ? 8B 06 85 C0 74 22", 1),
+			get_signature<void*>(SIGNATURE("BF ? ? ? ? 33 F6 F3 AB B8"), 1),
+			get_signature<void*>(SIGNATURE("BE ? ? ? ? 8B 06 85 C0 74 22"), 1),
 
-			get_pattern<void*>("50 89 04 8D", 3 + 1),
-			get_pattern<void*>("89 54 24 68 8B 14 8D", 4 + 3),
-			get_pattern<void*>("8B 04 85 ? ? ? ? 8B 08", 3),
-			get_pattern<void*>("8B 14 8D ? ? ? ? 89 10", 3),
+			get_signature<void*>(SIGNATURE("50 89 04 8D"), 3 + 1),
+			get_signature<void*>(SIGNATURE("89 54 24 68 8B 14 8D"), 4 + 3),
+			get_signature<void*>(SIGNATURE("8B 04 85 ? ? ? ? 8B 08"), 3),
+			get_signature<void*>(SIGNATURE("8B 14 8D ? ? ? ? 89 10"), 3),
 		};
 		void** allocs_end[] = {
-			get_pattern<void*>("81 FE ? ? ? ? 72 CD", 2),
+			get_signature<void*>(SIGNATURE("81 FE ? ? ? ? 72 CD"), 2),
 		};
 
 		ReadCall(alloc_function, orgMaybeAlloc);
 		InjectHook(alloc_function, MaybeAllocAndExpandArray);
 		m_currentAllocSize = alloc_size_var;
-		currentMemSpace = *allocs_begin[0];
 
-		rePatchFunc = [alloc_sizes, allocs_begin, allocs_end] {
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		allocList.Initialize(ReserveMemory, CommitMemory, systemInfo.dwPageSize, MAX_ALLOC_CAPACITY,
+			static_cast<void**>(*allocs_begin[0]), GAME_ALLOC_CAPACITY);
+
+		rePatchFunc = [alloc_sizes, allocs_begin, allocs_end] (bool patchBase) {
 			std::unique_ptr<ScopedUnprotect::Unprotect> Protect = ScopedUnprotect::UnprotectSectionOrFullModule( GetModuleHandle( nullptr ), ".text" );
 			
 			using namespace DynamicAllocList;
 
-			void** mem = static_cast<void**>(currentMemSpace);
+			void** mem = allocList.GetData();
+			const uint32_t capacity = static_cast<uint32_t>(allocList.GetCapacity());
 
 			for (uint32_t* addr : alloc_sizes)
 			{
-				Patch<uint32_t>(addr, currentAllocCapacity);
+				Patch<uint32_t>(addr, capacity);
 			}
-			for (void** addr : allocs_begin)
+			if (patchBase)
 			{
-				Patch<void**>(addr, mem);	
+				for (void** addr : allocs_begin)
+				{
+					Patch<void**>(addr, mem);	
+				}
 			}
 			for (void** addr : allocs_end)
 			{
-				Patch<void**>(addr, mem+currentAllocCapacity);	
+				Patch<void**>(addr, mem+capacity);	
 			}
 		};
-	}
-	TXN_CATCH();
+	});
 
 	// Lift the 1024 palettes limit
 	// Fixes a crash when minimizing excessively
-	try
+	Features::Install(L"DynamicPalettesList", [&]
 	{
 		using namespace DynamicPalettesList;
 
-		auto direct_draw_ptr = *get_pattern<LPDIRECTDRAW*>("A1 ? ? ? ? 33 FF 57", 1);
-		auto register_destructor_func = static_cast<decltype(RegisterDestructor)>(get_pattern("3B 31 74 24", -0x21));
+		auto direct_draw_ptr = *get_signature<LPDIRECTDRAW*>(SIGNATURE("A1 ? ? ? ? 33 FF 57"), 1);
+		auto register_destructor_func = static_cast<decltype(RegisterDestructor)>(get_signature(SIGNATURE("3B 31 74 24"), -0x21));
 
-		auto create_palette_func = get_pattern("3D ? ? ? ? 73 6C", -0xB);
+		auto create_palette_func = get_signature(SIGNATURE("3D ? ? ? ? 73 6C"), -0xB);
 
 		g_pDirectDraw = direct_draw_ptr;
 		RegisterDestructor = register_destructor_func;
 
 		InjectHook(create_palette_func, CreateD3DPalette, PATCH_JUMP);
-	}
-	TXN_CATCH();
+	});
 
 	// Fix a crash when minimizing during a support car race
 	// Windshield decals attempt to reinitialize when they shouldn't (those cars have no decals)
 	// Also fix a crash when minimizing during loading
-	try
+	Features::Install(L"DecalsCrashFix", [&]
 	{
 		using namespace DecalsCrashFix;
 
-		auto init_decals = pattern("E8 ? ? ? ? E8 ? ? ? ? 85 C0 74 05 E8 ? ? ? ? E8 ? ? ? ? B8").get_one();
-		auto cars_in_race_details = *get_pattern<CarDetails**>("8B 0D ? ? ? ? 8A 44 01 10", 2);
-		auto unk_decal_resource = *get_pattern<void**>("89 0D ? ? ? ? 8B 91", 2);
+		auto init_decals = get_signature_match(SIGNATURE("E8 ? ? ? ? E8 ? ? ? ? 85 C0 74 05 E8 ? ? ? ? E8 ? ? ? ? B8"));
+		auto unk_decal_resource = *get_signature<void**>(SIGNATURE("89 0D ? ? ? ? 8B 91"), 2);
+
+		if (gCarsInRaceDetails == nullptr)
+		{
+			throw hook::txn_exception();
+		}
 
 		ReadCall(init_decals.get<void>(-5), orgSkinsLoad);
 		InjectHook(init_decals.get<void>(-5), SkinsLoad_NullCheck);
 
 		ReadCall(init_decals.get<void>(0), orgInitializeDecals);
 		InjectHook(init_decals.get<void>(0), InitializeDecals_IDCheck);
-		gCarsInRaceDetails = cars_in_race_details;
 
 		gUnkDecalResource = unk_decal_resource;
-	}
-	TXN_CATCH();
+
+		if (PrefetchCarFiles)
+		{
+			SkinsPrefetch::HookFileOpens();
+		}
+	});
 
 	// Take the process icon from toca2.exe
 	// + overriden window proc
-	try
+	Features::Install(L"WindowProc", [&]
 	{
-		auto register_class = get_pattern("FF 15 ? ? ? ? 66 85 C0", 2);
-		auto requests_exit = *get_pattern<BOOL*>("A1 ? ? ? ? 85 C0 74 83", 1);
+		auto register_class = get_signature(SIGNATURE("FF 15 ? ? ? ? 66 85 C0"), 2);
+		auto requests_exit = *get_signature<BOOL*>(SIGNATURE("A1 ? ? ? ? 85 C0 74 83"), 1);
 
 		bRequestsExit = requests_exit;
 		Patch(register_class, &pRegisterClassA_SetIconAndWndProc);
-	}
-	TXN_CATCH();
-
-	// Metric/imperial switch
-	if (hookUnits)
-	{
-		try
-		{
-			using namespace MetricSwitch;
-
-			void* addresses[] = {
-				get_pattern("8B EC A1 ? ? ? ? 8B 90", 2 + 1), // Distance unit conversion
-				get_pattern("83 EC 08 A1 ? ? ? ? 53 56", 3 + 1),
-				get_pattern("89 43 EC A1", 3 + 1),
-			};
-
-			auto get_distance_unit_string = pattern("A1 ? ? ? ? 8B 88 ? ? ? ? B8").get_one();
-			auto prepare_ui_data = pattern("A1 ? ? ? ? 8B 88 ? ? ? ? 85 C9 75 1C A1").count_hint(2); // 2 in 4.1, 1 in 1.0
-			auto prepare_ui_data_10_only = pattern("39 9A ? ? ? ? 75 1C").count_hint(1); // 1.0 only, in 4.1 it shares the above pattern
-
-			fakeGamePtrForMetric = reinterpret_cast<char*>(&UseMetric) - *get_distance_unit_string.get<uint32_t>(5 + 2);
-
-			for (void* addr : addresses)
-			{
-				Patch(addr, &fakeGamePtrForMetric);
-			}
-
-			Patch(get_distance_unit_string.get<void>(1), &fakeGamePtrForMetric);
-
-			prepare_ui_data.for_each_result([](hook::pattern_match match) {
-				Patch(match.get<void>(1), &fakeGamePtrForMetric);	
-			});
-			prepare_ui_data_10_only.for_each_result([](hook::pattern_match match) {
-				Patch(match.get<void>(1), &fakeGamePtrForMetric);	
-			});
-		}
-		TXN_CATCH();
-	}
+	});
 
 	// Forced in-car rear view mirrors
 	if (forcedMirrors)
 	{
-		try
+		Features::Install(L"ForcedMirrors", [&]
 		{
 			using namespace ForcedMirrors;
 
 			void* addresses[] = {
-				get_pattern("8B 46 04 8B 15", 3 + 2),
-				get_pattern("8B 15 ? ? ? ? 8A 8A", 2),
+				get_signature(SIGNATURE("8B 46 04 8B 15"), 3 + 2),
+				get_signature(SIGNATURE("8B 15 ? ? ? ? 8A 8A"), 2),
 			};
 
 			void* short_jmps[] = {
-				get_pattern("8B 14 AD ? ? ? ? 85 D2", -2),
+				get_signature(SIGNATURE("8B 14 AD ? ? ? ? 85 D2"), -2),
 			};
 
 			const std::pair<void*, size_t> nops[] = {
-				{ get_pattern("8B 04 AD ? ? ? ? 85 C0", -2), 2 },
-				{ get_pattern("A1 ? ? ? ? 3B F3", -0x28), 6 }, // Unknown
-				{ get_pattern("0F BE BE ? ? ? ? 38 9A", 7 + 6), 6 },
-				{ get_pattern("0F 84 ? ? ? ? 3A CB", 6 + 2), 6 },
+				{ get_signature(SIGNATURE("8B 04 AD ? ? ? ? 85 C0"), -2), 2 },
+				{ get_signature(SIGNATURE("A1 ? ? ? ? 3B F3"), -0x28), 6 }, // Unknown
+				{ get_signature(SIGNATURE("0F BE BE ? ? ? ? 38 9A"), 7 + 6), 6 },
+				{ get_signature(SIGNATURE("0F 84 ? ? ? ? 3A CB"), 6 + 2), 6 },
 			};
 
-			auto mov_dl_1_nop = pattern("33 C9 84 D2 5F").get_one();
+			auto mov_dl_1_nop = get_signature_match(SIGNATURE("33 C9 84 D2 5F"));
 
-			uint32_t offset = *get_pattern<uint32_t>("8A 8A ? ? ? ? 84 C9", 2);
+			uint32_t offset = *get_signature<uint32_t>(SIGNATURE("8A 8A ? ? ? ? 84 C9"), 2);
 			fakeGamePtrForMirror = reinterpret_cast<char*>(&ForcedMirror) - offset;
 
 			// mov dl, 1
@@ -995,34 +2442,32 @@ void OnInitializeHook()
 			{
 				Nop(addr.first, addr.second);
 			}
-		}
-		TXN_CATCH();
+		});
 	}
 
 	// Full range steering & gear shifting anim
 	// when using the center interior cam
-	try
+	Features::Install(L"FullRangeSteeringAnim", [&]
 	{
 		using namespace FullRangeSteeringAnim;
 
-		auto arms_animate = get_pattern("E8 ? ? ? ? 83 F8 02 75 60");
-		auto dashboard_update = get_pattern("E8 ? ? ? ? 83 F8 04 75 26");
+		auto arms_animate = get_signature(SIGNATURE("E8 ? ? ? ? 83 F8 02 75 60"));
+		auto dashboard_update = get_signature(SIGNATURE("E8 ? ? ? ? 83 F8 04 75 26"));
 
 		ReadCall(arms_animate, orgGetCurrentCamera);
 		InjectHook(arms_animate, GetCurrentCamera_FakeInteriorCam);
 		InjectHook(dashboard_update, GetCurrentCamera_FakeInteriorCam);
-	}
-	TXN_CATCH();
+	});
 
 	// Options to hide the steering wheel and arms
-	try
+	Features::Install(L"WheelArmsToggle", [&]
 	{
 		using namespace WheelArmsToggle;
 
-		auto rotate_wheel = get_pattern("66 89 3D ? ? ? ? E8", 7);
-		auto animate_arms_get_cam = get_pattern("E8 ? ? ? ? 83 F8 02 75 60");
+		auto rotate_wheel = get_signature(SIGNATURE("66 89 3D ? ? ? ? E8"), 7);
+		auto animate_arms_get_cam = get_signature(SIGNATURE("E8 ? ? ? ? 83 F8 02 75 60"));
 
-		auto arms = *get_pattern<ArmsStruct*>("8B 0D ? ? ? ? 6A 69", 2);
+		auto arms = *get_signature<ArmsStruct*>(SIGNATURE("8B 0D ? ? ? ? 6A 69"), 2);
 
 		gArms = arms;
 
@@ -1031,20 +2476,20 @@ void OnInitializeHook()
 
 		ReadCall(animate_arms_get_cam, orgGetCurrentCamera);
 		InjectHook(animate_arms_get_cam, GetCurrentCamera_ToggleArms);
-	}
-	TXN_CATCH();
+	});
 
 	// Mirror quality setting for the in-car mirror
 	// Default size is 64x32
-	try
+	Features::Install(L"MirrorQuality", [&]
 	{
 		using namespace MirrorQuality;
 
-		auto create_mirror_rt = get_pattern("E8 ? ? ? ? 8B C3 68");
-		auto set_mirror_bounds = get_pattern("8D 54 24 1C 8D 44 24 24 52 50 51 E8", 11);
+		auto create_mirror_rt = get_signature(SIGNATURE("E8 ? ? ? ? 8B C3 68"));
+		auto set_mirror_bounds = get_signature(SIGNATURE("8D 54 24 1C 8D 44 24 24 52 50 51 E8"), 11);
 
-		auto d3d_resources_ptr = *get_pattern<void*>("68 ? ? ? ? E8 ? ? ? ? 8D 54 24 14", 1);
-		auto mirror_surface_id = *get_pattern<uint32_t>("68 ? ? ? ? E8 ? ? ? ? A3 ? ? ? ? E8 ? ? ? ? E8 ? ? ? ? E8", 1);
+		auto d3d_resources_ptr = *get_signature<void*>(SIGNATURE("68 ? ? ? ? E8 ? ? ? ? 8D 54 24 14"), 1);
+		auto mirror_surface_id = *get_signature<uint32_t>(SIGNATURE("68 ? ? ? ? E8 ? ? ? ? A3 ? ? ? ? E8 ? ? ? ? E8 ? ? ? ? E8"), 1);
+		auto get_current_camera_ptr = get_signature(SIGNATURE("E8 ? ? ? ? 83 F8 04 75 1A"));
 
 		ReadCall(create_mirror_rt, orgCreateViewport);
 		InjectHook(create_mirror_rt, CreateViewport_InCarMirrorScale);
@@ -1052,46 +2497,22 @@ void OnInitializeHook()
 		ReadCall(set_mirror_bounds, orgSetViewportBounds);
 		InjectHook(set_mirror_bounds, SetViewportBounds_InCarMirror);
 
-		void* entriesInfoPtr = *reinterpret_cast<void**>(static_cast<char*>(d3d_resources_ptr) + 16);
-		void* mirrorEntry = static_cast<char*>(entriesInfoPtr) + 1132*mirror_surface_id;
-		uint16_t* size = reinterpret_cast<uint16_t*>(static_cast<char*>(mirrorEntry) + 4);
-		*size = InCarMirrorRes;
-	}
-	TXN_CATCH();
-
-	// Allow for more characters in names (and for longer names)
-	try
-	{
-		using namespace LongerUserNames;
-
-		auto is_legal_name_char = get_pattern("85 C0 75 09 83 FB 08 0F 85 ? ? ? ? A1 ? ? ? ? 33 C9", -5);
-		auto get_typed_key = get_pattern("66 89 44 24 ? E8 ? ? ? ? E8 ? ? ? ? 8B D8", 5 + 5);
-		auto max_name_length = get_pattern("83 F8 ? 7D 4D", 2);
-		auto get_decal_width = get_pattern("F3 A4 E8 ? ? ? ? 33 C9 3D", 2);
-
-		void* init_decals[] = {
-			get_pattern("50 53 E8 ? ? ? ? E9", 2),
-			get_pattern("E8 ? ? ? ? E9 ? ? ? ? 83 FF FF"),
-			get_pattern("E8 ? ? ? ? 8B 6C 24 10 33 C9"),
-		};
-
-		InjectHook(is_legal_name_char, IsLegalCharForName);
+		ReadCall(get_current_camera_ptr, GetCurrentCamera);
 
-		ReadCall(get_typed_key, orgGetTypedKey);
-		InjectHook(get_typed_key, GetTypedKey_ConvertToChar);
+		D3DResources::entriesInfo = *reinterpret_cast<void**>(static_cast<char*>(d3d_resources_ptr) + 16);
+		SurfaceInspector::mirrorSurfaceID = mirror_surface_id;
 
-		ReadCall(init_decals[0], orgInitializeWindshieldDecal);
-		for (void* addr : init_decals)
-		{
-			InjectHook(addr, InitializeWindshieldDecal_SkipDot);
-		}
+		uint16_t* size = D3DResources::GetEntrySize(mirror_surface_id);
+		*size = InCarMirrorRes;
 
-		Patch<uint8_t>(max_name_length, 15);
+		activeMirrorRes = InCarMirrorRes;
+		mirrorSurfaceSize = size;
+		governor.Initialize(64, InCarMirrorRes, MirrorFrameBudget);
+	});
 
-		ReadCall(get_decal_width, orgGetTextWidth);
-		InjectHook(get_decal_width, GetTextWidth_ExtractLastName);
-	}
-	TXN_CATCH();
+	// Hooks whose call sites are only reached once the game is already running
+	// get resolved on a worker thread and applied from the game thread
+	DeferredHooks::Start(hookUnits, timersHooked);
 }
 
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
@@ -1102,5 +2523,10 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 	{
 		hDLLModule = hinstDLL;
 	}
+	else if (fdwReason == DLL_PROCESS_DETACH)
+	{
+		DynamicAllocList::ReportHistogram();
+		ExitTimer::Report();
+	}
 	return TRUE;
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+// Hooks methods of COM objects by replacing their vtable slots.
+// A vtable is shared by all objects of the same class, so hooking one object hooks all of them - including ones created earlier.
+// Vtables live in read-only memory, so the caller makes the slot writable.
+namespace VTableHook
+{
+	inline void** GetVTable(void* object)
+	{
+		return *static_cast<void***>(object);
+	}
+
+	template<typename T>
+	bool IsHooked(void* object, size_t index, T hook)
+	{
+		return GetVTable(object)[index] == reinterpret_cast<void*>(hook);
+	}
+
+	// withWritableSlot(void* address, size_t size, write) must call write() with the slot writable, and return false if it couldn't.
+	// Hooking an already hooked slot is a no-op, so original never ends up pointing at the hook itself
+	template<typename T, typename WithWritableSlot>
+	bool Hook(void* object, size_t index, T hook, T& original, WithWritableSlot&& withWritableSlot)
+	{
+		if (IsHooked(object, index, hook))
+		{
+			return true;
+		}
+
+		void** slot = &GetVTable(object)[index];
+		return withWritableSlot(static_cast<void*>(slot), sizeof(*slot), [&]
+		{
+			original = reinterpret_cast<T>(*slot);
+			*slot = reinterpret_cast<void*>(hook);
+		});
+	}
+}
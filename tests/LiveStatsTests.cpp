@@ -0,0 +1,285 @@
+#include "TestCommon.h"
+
+#include "LiveStats.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Every field holds the same value, so a torn read shows up as a mix of values
+	LiveStats::Data MakeData(uint32_t value)
+	{
+		LiveStats::Data data;
+		uint32_t* fields = reinterpret_cast<uint32_t*>(&data);
+		for (size_t i = 0; i < sizeof(data) / sizeof(uint32_t); i++)
+		{
+			fields[i] = value;
+		}
+		return data;
+	}
+
+	bool IsConsistent(const LiveStats::Data& data)
+	{
+		const uint32_t* fields = reinterpret_cast<const uint32_t*>(&data);
+		for (size_t i = 1; i < sizeof(data) / sizeof(uint32_t); i++)
+		{
+			if (fields[i] != fields[0]) return false;
+		}
+		return true;
+	}
+}
+
+TEST(LiveStats_InitializePage)
+{
+	auto page = std::make_unique<LiveStats::Page>();
+	LiveStats::InitializePage(page.get());
+	CHECK(page->magic == LiveStats::PAGE_MAGIC);
+	CHECK(page->version == LiveStats::PAGE_VERSION);
+	CHECK(page->dataSize == sizeof(LiveStats::Data));
+
+	LiveStats::Data data = MakeData(1);
+	CHECK(LiveStats::TryRead(page.get(), data));
+	CHECK(data.configEpoch == 0 && data.restoreAllocations.numRestores == 0);
+}
+
+TEST(LiveStats_NoReadDuringWrite)
+{
+	auto page = std::make_unique<LiveStats::Page>();
+	LiveStats::InitializePage(page.get());
+
+	// As if the writer stalled halfway through an update
+	page->sequence.store(1);
+	LiveStats::Data data;
+	CHECK(!LiveStats::TryRead(page.get(), data));
+
+	page->sequence.store(2);
+	CHECK(LiveStats::TryRead(page.get(), data));
+}
+
+TEST(LiveStats_ConcurrentReadsAreConsistent)
+{
+	auto page = std::make_unique<LiveStats::Page>();
+	LiveStats::InitializePage(page.get());
+	LiveStats::Write(page.get(), MakeData(0));
+
+	std::atomic<bool> done { false };
+	std::thread writer([&]
+	{
+		for (uint32_t i = 1; i <= 200000; i++)
+		{
+			LiveStats::Write(page.get(), MakeData(i));
+		}
+		done = true;
+	});
+
+	uint32_t numReads = 0, numTorn = 0;
+	while (!done)
+	{
+		LiveStats::Data data;
+		if (LiveStats::TryRead(page.get(), data))
+		{
+			numReads++;
+			if (!IsConsistent(data)) numTorn++;
+		}
+	}
+	writer.join();
+
+	CHECK(numTorn == 0);
+	LiveStats::Data data;
+	CHECK(LiveStats::TryRead(page.get(), data));
+	CHECK(IsConsistent(data) && data.configEpoch == 200000);
+	std::printf("  %u consistent reads\n", numReads);
+}
+
+// A page written by the version before the restore stats were added
+TEST(LiveStats_OlderPageReadsAsZeroes)
+{
+	auto page = std::make_unique<LiveStats::Page>();
+	LiveStats::InitializePage(page.get());
+	LiveStats::Write(page.get(), MakeData(7));
+	page->version = 5;
+	page->dataSize = offsetof(LiveStats::Data, restoreAllocations);
+
+	LiveStats::Data data = MakeData(1);
+	CHECK(LiveStats::TryRead(page.get(), data));
+	CHECK(data.configEpoch == 7 && data.directDrawFrame.numFlip == 7);
+	CHECK(data.restoreAllocations.numRestores == 0 && data.restoreAllocations.allocations == 0);
+}
+
+TEST(LiveStats_HasField)
+{
+	auto page = std::make_unique<LiveStats::Page>();
+	LiveStats::InitializePage(page.get());
+
+	constexpr size_t restoreOffset = offsetof(LiveStats::Data, restoreAllocations);
+	constexpr size_t restoreSize = sizeof(LiveStats::Data::restoreAllocations);
+	CHECK(LiveStats::HasField(page.get(), 6, restoreOffset, restoreSize));
+
+	// Newer versions only append, so what this reader knows about is still there
+	page->version = LiveStats::PAGE_VERSION + 1;
+	page->dataSize = sizeof(LiveStats::Data) + 16;
+	CHECK(LiveStats::HasField(page.get(), 6, restoreOffset, restoreSize));
+
+	page->version = 5;
+	page->dataSize = restoreOffset;
+	CHECK(!LiveStats::HasField(page.get(), 6, restoreOffset, restoreSize));
+	CHECK(LiveStats::HasField(page.get(), 5, offsetof(LiveStats::Data, directDrawFrame), sizeof(LiveStats::Data::directDrawFrame)));
+
+	// A version claiming a field it's too short for
+	page->version = 6;
+	CHECK(!LiveStats::HasField(page.get(), 6, restoreOffset, restoreSize));
+}
+
+#ifndef _WIN32
+namespace
+{
+	// The page as the game publishes it, followed by the steps the two processes sync on
+	struct SharedSection
+	{
+		LiveStats::Page page;
+		std::atomic<uint32_t> step;
+	};
+	static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+	enum Step : uint32_t
+	{
+		WRITING = 1,
+		STALLED, // The writer stopped halfway through an update
+		RESUME,
+		DONE,
+	};
+
+	constexpr uint32_t NUM_WRITES = 200000;
+
+	bool WaitForStep(const std::atomic<uint32_t>& step, uint32_t value)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (step.load() < value)
+		{
+			if (std::chrono::steady_clock::now() > deadline) return false;
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+	[[noreturn]] void RunWriterProcess(SharedSection* section)
+	{
+		section->step = WRITING;
+		for (uint32_t i = 1; i <= NUM_WRITES; i++)
+		{
+			LiveStats::Write(&section->page, MakeData(i));
+		}
+
+		// Half of an update, the way a writer interrupted by a crash or the debugger leaves the page
+		const LiveStats::Data next = MakeData(NUM_WRITES + 1);
+		const uint32_t seq = section->page.sequence.load(std::memory_order_relaxed);
+		section->page.sequence.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		std::memcpy(&section->page.data, &next, sizeof(next) / 2);
+		section->step = STALLED;
+
+		const bool resumed = WaitForStep(section->step, RESUME);
+		std::memcpy(&section->page.data, &next, sizeof(next));
+		section->page.sequence.store(seq + 2, std::memory_order_release);
+		section->step = DONE;
+		_exit(resumed ? 0 : 1);
+	}
+}
+
+// Like the game and the stats reader - a writer and a reader in separate processes, sharing the page through a named section
+TEST(LiveStats_SharedMemoryAcrossProcesses)
+{
+	const std::string name = "/SilentPatchTOCA2_Stats_" + std::to_string(getpid());
+	const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	CHECK(fd != -1);
+	if (fd == -1) return;
+	shm_unlink(name.c_str());
+
+	CHECK(ftruncate(fd, sizeof(SharedSection)) == 0);
+	void* view = mmap(nullptr, sizeof(SharedSection), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	CHECK(view != MAP_FAILED);
+	if (view == MAP_FAILED) return;
+
+	auto* section = new (view) SharedSection;
+	LiveStats::InitializePage(&section->page);
+	section->step = 0;
+
+	const pid_t writer = fork();
+	CHECK(writer != -1);
+	if (writer == 0)
+	{
+		RunWriterProcess(section);
+	}
+
+	uint32_t numReads = 0, numTorn = 0, numRetries = 0;
+	if (writer != -1)
+	{
+		CHECK(WaitForStep(section->step, WRITING));
+		while (section->step.load() < STALLED)
+		{
+			LiveStats::Data data;
+			if (LiveStats::TryRead(&section->page, data))
+			{
+				numReads++;
+				if (!IsConsistent(data)) numTorn++;
+			}
+			else
+			{
+				numRetries++;
+			}
+		}
+
+		// The reader never returns a half written update, no matter how many times it retries
+		LiveStats::Data data;
+		bool readWhileStalled = false;
+		for (int i = 0; i < 1000; i++)
+		{
+			readWhileStalled = readWhileStalled || LiveStats::TryRead(&section->page, data);
+		}
+		CHECK(!readWhileStalled);
+
+		section->step = RESUME;
+		int status = 0;
+		CHECK(waitpid(writer, &status, 0) == writer);
+		CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+		CHECK(LiveStats::TryRead(&section->page, data));
+		CHECK(IsConsistent(data) && data.configEpoch == NUM_WRITES + 1);
+	}
+	CHECK(numTorn == 0);
+
+	munmap(view, sizeof(SharedSection));
+	std::printf("  %u consistent reads, %u retries during writes\n", numReads, numRetries);
+}
+#endif
+
+TEST(LiveStats_SurfaceFormats)
+{
+	LiveStats::SurfaceFormats formats {};
+	LiveStats::AddSurfaceFormat(formats, 0, 16);
+	LiveStats::AddSurfaceFormat(formats, 0x31545844, 0); // DXT1
+	LiveStats::AddSurfaceFormat(formats, 0, 16);
+	LiveStats::AddSurfaceFormat(formats, 0, 32);
+	LiveStats::AddSurfaceFormat(formats, 0, 8);
+	CHECK(formats.formats[0].bitCount == 16 && formats.formats[0].numSurfaces == 2);
+	CHECK(formats.formats[1].fourCC == 0x31545844 && formats.formats[1].numSurfaces == 1);
+	CHECK(formats.formats[3].bitCount == 8 && formats.numUnlistedSurfaces == 0);
+
+	// Formats past the last slot are only counted
+	LiveStats::AddSurfaceFormat(formats, 0, 24);
+	LiveStats::AddSurfaceFormat(formats, 0, 24);
+	LiveStats::AddSurfaceFormat(formats, 0, 32);
+	CHECK(formats.numUnlistedSurfaces == 2 && formats.formats[2].numSurfaces == 2);
+}
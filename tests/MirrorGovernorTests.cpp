@@ -0,0 +1,136 @@
+#include "TestCommon.h"
+
+#include "MirrorGovernor.h"
+
+#include <vector>
+
+namespace
+{
+	constexpr double FRAME_BUDGET = 16.0;
+
+	void Feed(MirrorGovernor& governor, double frameTimeMS, int numFrames)
+	{
+		for (int i = 0; i < numFrames; i++)
+		{
+			governor.AddFrameTime(frameTimeMS);
+		}
+	}
+}
+
+TEST(MirrorGovernor_DisabledWithoutBudget)
+{
+	MirrorGovernor governor;
+	governor.Initialize(64, 512, 0.0);
+
+	Feed(governor, 100.0, 1000);
+	CHECK(governor.GetResolution() == 512);
+	CHECK(governor.GetUpdateInterval() == 1);
+	for (int i = 0; i < 10; i++)
+	{
+		CHECK(governor.ShouldRenderFrame());
+	}
+}
+
+// A constant over-budget trace must not cascade through all the resolutions
+// while the game still renders the mirror at the old size
+TEST(MirrorGovernor_WaitsForResolutionToApply)
+{
+	MirrorGovernor governor;
+	governor.Initialize(64, 512, FRAME_BUDGET);
+
+	// 20 seconds at 20 ms per frame
+	Feed(governor, 20.0, 1000);
+	CHECK(governor.GetUpdateInterval() == MirrorGovernor::MAX_UPDATE_INTERVAL);
+	CHECK(governor.GetResolution() == 256);
+	CHECK(governor.GetAppliedResolution() == 512);
+	CHECK(governor.IsResolutionPending());
+
+	// The mirror gets recreated with the new size, only now the next step can be taken
+	governor.OnResolutionApplied(governor.GetResolution());
+	CHECK(!governor.IsResolutionPending());
+	Feed(governor, 20.0, 1000);
+	CHECK(governor.GetResolution() == 128);
+	CHECK(governor.IsResolutionPending());
+}
+
+TEST(MirrorGovernor_StepsDownInOrder)
+{
+	MirrorGovernor governor;
+	governor.Initialize(64, 512, FRAME_BUDGET);
+
+	std::vector<uint32_t> intervals;
+	for (int i = 0; i < 1000 && !governor.IsResolutionPending(); i++)
+	{
+		if (governor.AddFrameTime(20.0))
+		{
+			intervals.push_back(governor.GetUpdateInterval());
+		}
+	}
+	// The update interval goes up first, one step at a time
+	CHECK((intervals == std::vector<uint32_t>{ 2, 3, 3 }));
+	CHECK(governor.GetResolution() == 256);
+}
+
+TEST(MirrorGovernor_StepsUpInReverse)
+{
+	MirrorGovernor governor;
+	governor.Initialize(64, 512, FRAME_BUDGET);
+
+	// Push it all the way down, applying every resolution right away
+	for (int i = 0; i < 10000; i++)
+	{
+		governor.AddFrameTime(40.0);
+		governor.OnResolutionApplied(governor.GetResolution());
+		if (governor.GetResolution() == 64) break;
+	}
+	CHECK(governor.GetResolution() == 64);
+	CHECK(governor.GetUpdateInterval() == MirrorGovernor::MAX_UPDATE_INTERVAL);
+
+	// Plenty of headroom - resolution goes back up first, then the update interval goes down
+	uint16_t lastRes = governor.GetResolution();
+	bool resolutionRaisedAfterInterval = false;
+	for (int i = 0; i < 20000; i++)
+	{
+		if (governor.AddFrameTime(5.0))
+		{
+			if (governor.GetResolution() != lastRes && governor.GetUpdateInterval() != MirrorGovernor::MAX_UPDATE_INTERVAL)
+			{
+				resolutionRaisedAfterInterval = true;
+			}
+			lastRes = governor.GetResolution();
+			governor.OnResolutionApplied(lastRes);
+		}
+	}
+	CHECK(!resolutionRaisedAfterInterval);
+	CHECK(governor.GetResolution() == 512);
+	CHECK(governor.GetUpdateInterval() == 1);
+}
+
+TEST(MirrorGovernor_WithinBudgetStaysPut)
+{
+	MirrorGovernor governor;
+	governor.Initialize(64, 512, FRAME_BUDGET);
+
+	// Neither over the budget, nor with enough headroom to go up
+	Feed(governor, 14.0, 5000);
+	CHECK(governor.GetResolution() == 512);
+	CHECK(governor.GetUpdateInterval() == 1);
+}
+
+TEST(MirrorGovernor_RendersEveryNthFrame)
+{
+	MirrorGovernor governor;
+	governor.Initialize(64, 512, FRAME_BUDGET);
+
+	while (governor.GetUpdateInterval() < 3)
+	{
+		governor.AddFrameTime(20.0);
+	}
+
+	int numRendered = 0;
+	for (int i = 0; i < 30; i++)
+	{
+		if (governor.ShouldRenderFrame()) numRendered++;
+	}
+	CHECK(numRendered == 10);
+}
@@ -0,0 +1,211 @@
+#include "TestCommon.h"
+
+#include "Prefetch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	namespace fs = std::filesystem;
+
+	std::atomic<int> numOpenFiles;
+
+	void* OpenFile(const std::wstring& path)
+	{
+		auto* file = new std::ifstream(fs::path(path), std::ios::binary);
+		if (!file->is_open())
+		{
+			delete file;
+			return nullptr;
+		}
+		numOpenFiles++;
+		return file;
+	}
+
+	size_t ReadFile(void* file, void* buffer, size_t size)
+	{
+		auto* stream = static_cast<std::ifstream*>(file);
+		stream->read(static_cast<char*>(buffer), static_cast<std::streamsize>(size));
+		return static_cast<size_t>(stream->gcount());
+	}
+
+	void CloseFile(void* file)
+	{
+		numOpenFiles--;
+		delete static_cast<std::ifstream*>(file);
+	}
+
+	// Only '*' in the file name, enough for the tests
+	bool MatchesWildcard(std::wstring_view name, std::wstring_view pattern)
+	{
+		const size_t star = pattern.find(L'*');
+		if (star == std::wstring_view::npos) return name == pattern;
+
+		const std::wstring_view prefix = pattern.substr(0, star), suffix = pattern.substr(star + 1);
+		return name.size() >= prefix.size() + suffix.size() && name.substr(0, prefix.size()) == prefix &&
+			name.substr(name.size() - suffix.size()) == suffix;
+	}
+
+	std::vector<std::wstring> FindFiles(const std::wstring& pattern)
+	{
+		std::vector<std::wstring> files;
+		const fs::path patternPath(pattern);
+		std::error_code ec;
+		for (const fs::directory_entry& entry : fs::directory_iterator(patternPath.parent_path(), ec))
+		{
+			if (entry.is_regular_file() && MatchesWildcard(entry.path().filename().wstring(), patternPath.filename().wstring()))
+			{
+				files.push_back(entry.path().wstring());
+			}
+		}
+		return files;
+	}
+
+	constexpr Prefetch::FileSystem FILE_SYSTEM { OpenFile, ReadFile, CloseFile, FindFiles };
+
+	// A directory laid out like the game's car files, removed at the end of the test
+	struct TempCarDirectory
+	{
+		fs::path root;
+
+		TempCarDirectory()
+		{
+			root = fs::temp_directory_path() / ("SilentPatchTOCA2_PrefetchTests_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())));
+			fs::remove_all(root);
+			fs::create_directories(root / "cars");
+			WriteFile("cars/car3_skin.tga", 100000);
+			WriteFile("cars/car3_skin2.tga", 5000);
+			WriteFile("cars/car3_decals.bin", 300);
+			WriteFile("cars/car4_skin.tga", 7);
+		}
+
+		~TempCarDirectory()
+		{
+			std::error_code ec;
+			fs::remove_all(root, ec);
+		}
+
+		void WriteFile(const char* name, size_t size)
+		{
+			std::ofstream file(root / name, std::ios::binary);
+			const std::string contents(size, 'x');
+			file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+		}
+
+		std::wstring Path(const char* name) const
+		{
+			return (root / name).wstring();
+		}
+	};
+
+	void RunWorkerToCompletion(Prefetch::ReadAheadQueue& queue)
+	{
+		std::thread worker([&] { queue.RunWorker(); });
+		worker.join();
+	}
+}
+
+TEST(Prefetch_ExpandPaths)
+{
+	const auto paths = Prefetch::ExpandPaths(L"cars\\car{car}_*.tga;;sounds\\car{car}.wav;{car}{car}", 3);
+	CHECK((paths == std::vector<std::wstring>{ L"cars\\car3_*.tga", L"sounds\\car3.wav", L"33" }));
+	CHECK(Prefetch::ExpandPaths(L"", 3).empty());
+}
+
+TEST(Prefetch_LearnedListsRoundTrip)
+{
+	const std::vector<std::wstring> files { L"C:\\TOCA2\\cars\\car3_skin.tga", L"C:\\TOCA2\\cars\\car3_decals.bin" };
+	CHECK(Prefetch::JoinFileList(files) == L"C:\\TOCA2\\cars\\car3_skin.tga|C:\\TOCA2\\cars\\car3_decals.bin");
+	CHECK(Prefetch::ParseFileList(Prefetch::JoinFileList(files)) == files);
+	CHECK(Prefetch::ParseFileList(L"|a||b|").size() == 2);
+	CHECK(Prefetch::ParseFileList(L"").empty());
+}
+
+TEST(Prefetch_RecordAndMerge)
+{
+	std::vector<std::wstring> recorded;
+	Prefetch::RecordFile(recorded, L"a", 2);
+	Prefetch::RecordFile(recorded, L"a", 2);
+	Prefetch::RecordFile(recorded, L"b", 2);
+	Prefetch::RecordFile(recorded, L"c", 2);
+	CHECK((recorded == std::vector<std::wstring>{ L"a", L"b" }));
+
+	std::vector<std::wstring> learned { L"old" };
+	CHECK(Prefetch::MergeRecordedFiles(learned, recorded));
+	CHECK((learned == std::vector<std::wstring>{ L"a", L"b" }));
+	CHECK(recorded.empty());
+
+	// Loading the same files again doesn't need saving, and a load that recorded nothing keeps what was learned
+	recorded = learned;
+	CHECK(!Prefetch::MergeRecordedFiles(learned, recorded));
+	CHECK(!Prefetch::MergeRecordedFiles(learned, recorded));
+	CHECK(learned.size() == 2);
+}
+
+TEST(Prefetch_ReadsFilesAndWildcards)
+{
+	TempCarDirectory dir;
+	Prefetch::ReadAheadQueue queue(FILE_SYSTEM);
+
+	const auto paths = Prefetch::ExpandPaths(dir.Path("cars/car{car}_skin*.tga") + L";" + dir.Path("cars/car{car}_decals.bin") + L";" +
+		dir.Path("cars/missing.bin"), 3);
+	CHECK(queue.Add(paths));
+	RunWorkerToCompletion(queue);
+
+	CHECK(!queue.IsBusy());
+	CHECK(queue.GetFiles() == 3);
+	CHECK(queue.GetBytes() == 100000 + 5000 + 300);
+	CHECK(numOpenFiles == 0);
+
+	queue.ResetStats();
+	CHECK(queue.GetFiles() == 0 && queue.GetBytes() == 0);
+}
+
+// Paths queued while the worker is busy are picked up by the same worker, and a new one is only needed once it finishes
+TEST(Prefetch_QueueWhileRunning)
+{
+	TempCarDirectory dir;
+	Prefetch::ReadAheadQueue queue(FILE_SYSTEM);
+
+	CHECK(queue.Add({ dir.Path("cars/car3_skin.tga") }));
+	CHECK(queue.IsBusy());
+	CHECK(!queue.Add({ dir.Path("cars/car4_skin.tga") }));
+	CHECK(!queue.Add({}));
+	RunWorkerToCompletion(queue);
+	CHECK(queue.GetFiles() == 2);
+	CHECK(!queue.IsBusy());
+
+	CHECK(queue.Add({ dir.Path("cars/car3_decals.bin") }));
+	queue.OnWorkerFailedToStart();
+	CHECK(!queue.IsBusy());
+	CHECK(queue.Add({ dir.Path("cars/car4_skin.tga") }));
+	RunWorkerToCompletion(queue);
+	// The paths queued for the worker that failed to start are dropped
+	CHECK(queue.GetFiles() == 3);
+	CHECK(queue.GetBytes() == 100000 + 7 + 7);
+}
+
+// The game thread keeps queueing while a worker drains the queue - every path is read exactly once
+TEST(Prefetch_ConcurrentQueueing)
+{
+	TempCarDirectory dir;
+	Prefetch::ReadAheadQueue queue(FILE_SYSTEM);
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < 200; i++)
+	{
+		if (queue.Add({ dir.Path("cars/car3_decals.bin") }))
+		{
+			workers.emplace_back([&] { queue.RunWorker(); });
+		}
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	CHECK(queue.GetFiles() == 200);
+	CHECK(queue.GetBytes() == 200 * 300);
+	CHECK(!queue.IsBusy());
+}
@@ -0,0 +1,186 @@
+#include "TestCommon.h"
+
+#include "ReservedArray.h"
+
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	std::vector<size_t> commitSizes;
+	void* lastReservation;
+	size_t lastReservationSize;
+	bool failCommits;
+
+	void* ReserveMemory(size_t size)
+	{
+#ifdef _WIN32
+		lastReservation = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_READWRITE);
+#else
+		lastReservation = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (lastReservation == MAP_FAILED) lastReservation = nullptr;
+#endif
+		lastReservationSize = size;
+		return lastReservation;
+	}
+
+	bool CommitMemory(void* address, size_t size)
+	{
+		if (failCommits) return false;
+		commitSizes.push_back(size);
+#ifdef _WIN32
+		return VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+		return mprotect(address, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+	}
+
+	void FreeReservation()
+	{
+#ifdef _WIN32
+		VirtualFree(lastReservation, 0, MEM_RELEASE);
+#else
+		munmap(lastReservation, lastReservationSize);
+#endif
+		lastReservation = nullptr;
+	}
+
+	size_t GetPageSize()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		return systemInfo.dwPageSize;
+#else
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	constexpr size_t GAME_CAPACITY = 1024;
+	constexpr size_t MAX_CAPACITY = 1024 * 1024;
+
+	// Like the game's allocation list - pointers filling the initial array
+	struct GameList
+	{
+		void* entries[GAME_CAPACITY];
+
+		GameList()
+		{
+			for (size_t i = 0; i < GAME_CAPACITY; i++)
+			{
+				entries[i] = reinterpret_cast<void*>(i + 1);
+			}
+		}
+	};
+
+	void Reset()
+	{
+		commitSizes.clear();
+		failCommits = false;
+	}
+}
+
+// The first growth moves the entries out of the game's array, later ones only commit more pages in place
+TEST(ReservedArray_GrowsPageByPage)
+{
+	Reset();
+	GameList game;
+	const size_t pageSize = GetPageSize();
+	const size_t entriesPerPage = pageSize / sizeof(void*);
+
+	ReservedArray<void*> list;
+	list.Initialize(ReserveMemory, CommitMemory, pageSize, MAX_CAPACITY, game.entries, GAME_CAPACITY);
+	CHECK(list.GetData() == game.entries);
+
+	CHECK(list.Grow() == ReservedArray<void*>::GrowResult::Moved);
+	void** data = list.GetData();
+	CHECK(data != game.entries && data == lastReservation);
+	CHECK(lastReservationSize == MAX_CAPACITY * sizeof(void*));
+	CHECK(list.GetCapacity() == GAME_CAPACITY + entriesPerPage);
+
+	bool copied = true;
+	for (size_t i = 0; i < GAME_CAPACITY; i++)
+	{
+		copied = copied && data[i] == game.entries[i];
+	}
+	CHECK(copied);
+
+	bool zeroed = true;
+	for (size_t i = GAME_CAPACITY; i < list.GetCapacity(); i++)
+	{
+		zeroed = zeroed && data[i] == nullptr;
+	}
+	CHECK(zeroed);
+
+	for (int i = 0; i < 10; i++)
+	{
+		CHECK(list.Grow() == ReservedArray<void*>::GrowResult::Grown);
+		CHECK(list.GetData() == data);
+		// Every entry up to the capacity is usable
+		data[list.GetCapacity() - 1] = &game;
+	}
+	CHECK(list.GetCapacity() == GAME_CAPACITY + 11 * entriesPerPage);
+
+	// One page more every time
+	bool pageByPage = true;
+	for (size_t i = 0; i < commitSizes.size(); i++)
+	{
+		pageByPage = pageByPage && commitSizes[i] == (GAME_CAPACITY + (i + 1) * entriesPerPage) * sizeof(void*);
+	}
+	CHECK(pageByPage);
+
+	FreeReservation();
+}
+
+TEST(ReservedArray_StopsAtMaxCapacity)
+{
+	Reset();
+	GameList game;
+	const size_t pageSize = GetPageSize();
+	const size_t entriesPerPage = pageSize / sizeof(void*);
+	const size_t maxCapacity = GAME_CAPACITY + 3 * entriesPerPage;
+
+	ReservedArray<void*> list;
+	list.Initialize(ReserveMemory, CommitMemory, pageSize, maxCapacity, game.entries, GAME_CAPACITY);
+	for (int i = 0; i < 3; i++)
+	{
+		CHECK(list.Grow() != ReservedArray<void*>::GrowResult::Failed);
+	}
+	CHECK(list.GetCapacity() == maxCapacity);
+	CHECK(list.Grow() == ReservedArray<void*>::GrowResult::AtMaxCapacity);
+	CHECK(list.GetCapacity() == maxCapacity);
+	CHECK(commitSizes.size() == 3);
+
+	FreeReservation();
+}
+
+// A failed first commit leaves the entries in the game's array, and the next growth retries the move
+TEST(ReservedArray_FailedCommitKeepsGameArray)
+{
+	Reset();
+	GameList game;
+	const size_t pageSize = GetPageSize();
+
+	ReservedArray<void*> list;
+	list.Initialize(ReserveMemory, CommitMemory, pageSize, MAX_CAPACITY, game.entries, GAME_CAPACITY);
+
+	failCommits = true;
+	CHECK(list.Grow() == ReservedArray<void*>::GrowResult::Failed);
+	CHECK(list.GetData() == game.entries);
+	CHECK(list.GetCapacity() == GAME_CAPACITY);
+
+	failCommits = false;
+	CHECK(list.Grow() == ReservedArray<void*>::GrowResult::Moved);
+	CHECK(list.GetData() != game.entries && list.GetData()[GAME_CAPACITY - 1] == game.entries[GAME_CAPACITY - 1]);
+
+	FreeReservation();
+}
@@ -0,0 +1,331 @@
+#include "TestCommon.h"
+
+#include "Signature.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace
+{
+	// What get_pattern does - a plain byte by byte comparison at every offset
+	std::vector<const uint8_t*> ReferenceScan(const Signatures::SignatureView& sig, const uint8_t* begin, const uint8_t* end)
+	{
+		std::vector<const uint8_t*> results;
+		if (static_cast<size_t>(end - begin) < sig.size) return results;
+
+		for (const uint8_t* ptr = begin; ptr <= end - sig.size; ptr++)
+		{
+			bool matches = true;
+			for (size_t i = 0; i < sig.size; i++)
+			{
+				if ((ptr[i] & sig.mask[i]) != sig.bytes[i])
+				{
+					matches = false;
+					break;
+				}
+			}
+			if (matches) results.push_back(ptr);
+		}
+		return results;
+	}
+
+	// How ModUtils' hook::pattern turns a pattern string into bytes and a mask - spaces are skipped,
+	// every '?' is a wildcard byte and hex digits pair up into bytes
+	void TransformHookPattern(std::string_view pattern, std::vector<uint8_t>& bytes, std::vector<uint8_t>& mask)
+	{
+		auto digitValue = [](char ch) -> uint8_t {
+			if (ch >= 'A' && ch <= 'F') return static_cast<uint8_t>(ch - 'A' + 10);
+			if (ch >= 'a' && ch <= 'f') return static_cast<uint8_t>(ch - 'a' + 10);
+			return static_cast<uint8_t>(ch - '0');
+		};
+
+		uint8_t tempDigit = 0;
+		bool tempFlag = false;
+		for (char ch : pattern)
+		{
+			if (ch == ' ')
+			{
+				continue;
+			}
+			if (ch == '?')
+			{
+				bytes.push_back(0);
+				mask.push_back(0);
+			}
+			else if (!tempFlag)
+			{
+				tempDigit = static_cast<uint8_t>(digitValue(ch) << 4);
+				tempFlag = true;
+			}
+			else
+			{
+				bytes.push_back(tempDigit | digitValue(ch));
+				mask.push_back(0xFF);
+				tempFlag = false;
+			}
+		}
+	}
+
+	template<size_t N>
+	bool MatchesHookPattern(const Signatures::Signature<N>& sig, std::string_view pattern)
+	{
+		std::vector<uint8_t> bytes, mask;
+		TransformHookPattern(pattern, bytes, mask);
+		return bytes.size() == N && std::equal(bytes.begin(), bytes.end(), sig.bytes) && std::equal(mask.begin(), mask.end(), sig.mask);
+	}
+
+	// Reads SIGNATURE_BENCHMARK_DUMP without tripping /sdl over getenv
+	std::string GetDumpPath()
+	{
+#ifdef _MSC_VER
+		char* value = nullptr;
+		size_t length = 0;
+		std::string result;
+		if (_dupenv_s(&value, &length, "SIGNATURE_BENCHMARK_DUMP") == 0 && value != nullptr)
+		{
+			result = value;
+		}
+		free(value);
+		return result;
+#else
+		const char* value = std::getenv("SIGNATURE_BENCHMARK_DUMP");
+		return value != nullptr ? value : "";
+#endif
+	}
+
+	// A selection of the signatures the patch uses, from short ones with common bytes to long ones with many wildcards
+	const Signatures::SignatureView& GetTestSignature(size_t index)
+	{
+		static constexpr auto sig0 = SIGNATURE("33 C9 84 D2 5F");
+		static constexpr auto sig1 = SIGNATURE("BF E8 03 00 00");
+		static constexpr auto sig2 = SIGNATURE("50 89 04 8D");
+		static constexpr auto sig3 = SIGNATURE("A1 ? ? ? ? 8B 88 ? ? ? ? 85 C9 75 1C A1");
+		static constexpr auto sig4 = SIGNATURE("DC 0D ? ? ? ? D9 C9 DC 0D ? ? ? ? D9 C9 D9 1D ? ? ? ? D9 1D ? ? ? ? EB 14");
+		static constexpr auto sig5 = SIGNATURE("E8 ? ? ? ? E8 ? ? ? ? 85 C0 74 05 E8 ? ? ? ? E8 ? ? ? ? B8");
+		static constexpr auto sig6 = SIGNATURE("89 43 EC A1");
+		static constexpr auto sig7 = SIGNATURE("8B 04 85 ? ? ? ? 8B 08");
+		static const Signatures::SignatureView views[] = {
+			sig0.view(), sig1.view(), sig2.view(), sig3.view(), sig4.view(), sig5.view(), sig6.view(), sig7.view(),
+		};
+		return views[index];
+	}
+	constexpr size_t NUM_TEST_SIGNATURES = 8;
+
+	// Random bytes skewed towards the ones common in x86 code, so anchors get plenty of false candidates
+	std::vector<uint8_t> MakeCodeLikeBuffer(size_t size, uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> byteDist(0, 255);
+		std::uniform_int_distribution<int> commonDist(0, static_cast<int>(std::size(Signatures::detail::COMMON_BYTES)) - 1);
+
+		std::vector<uint8_t> buffer(size);
+		for (uint8_t& byte : buffer)
+		{
+			byte = (rng() % 4) != 0 ? Signatures::detail::COMMON_BYTES[commonDist(rng)] : static_cast<uint8_t>(byteDist(rng));
+		}
+		return buffer;
+	}
+
+	void Plant(std::vector<uint8_t>& buffer, const Signatures::SignatureView& sig, size_t offset, std::mt19937& rng)
+	{
+		for (size_t i = 0; i < sig.size; i++)
+		{
+			buffer[offset + i] = sig.mask[i] != 0 ? sig.bytes[i] : static_cast<uint8_t>(rng());
+		}
+	}
+
+	constexpr Signatures::Implementation IMPLEMENTATIONS[] = {
+		Signatures::Implementation::Scalar, Signatures::Implementation::SSE2, Signatures::Implementation::AVX2,
+	};
+
+	bool ScanAll(Signatures::Implementation impl, const Signatures::SignatureView& sig, const uint8_t* begin, const uint8_t* end,
+		std::vector<const uint8_t*>& results)
+	{
+		results.clear();
+		return Signatures::ScanWith(impl, sig, begin, end, results);
+	}
+
+	// Implementations not available here are skipped
+	bool MatchesReference(const Signatures::SignatureView& sig, const uint8_t* begin, const uint8_t* end, const std::vector<const uint8_t*>& expected)
+	{
+		std::vector<const uint8_t*> results;
+		for (Signatures::Implementation impl : IMPLEMENTATIONS)
+		{
+			if (ScanAll(impl, sig, begin, end, results) && results != expected) return false;
+		}
+
+		results.clear();
+		Signatures::Scan(sig, begin, end, results);
+		return results == expected;
+	}
+}
+
+TEST(Signature_Compile)
+{
+	constexpr auto sig = SIGNATURE("8B 0D ? ? ? ? DF 6C 24 04");
+	static_assert(sig.size() == 10);
+	CHECK(sig.bytes[0] == 0x8B && sig.mask[0] == 0xFF);
+	CHECK(sig.bytes[2] == 0x00 && sig.mask[2] == 0x00);
+	CHECK(sig.bytes[9] == 0x04 && sig.mask[9] == 0xFF);
+	// 0xDF is the only byte not listed as common
+	CHECK(sig.anchor == 6);
+}
+
+// Every scanner must find exactly what the reference does, including matches overlapping
+// each other and ones ending right at the end of the range, from every start alignment
+TEST(Signature_MatchesReference)
+{
+	std::mt19937 rng(1234);
+	for (uint32_t round = 0; round < 4; round++)
+	{
+		std::vector<uint8_t> buffer = MakeCodeLikeBuffer(64 * 1024 + 37, round);
+		for (size_t sigIndex = 0; sigIndex < NUM_TEST_SIGNATURES; sigIndex++)
+		{
+			const Signatures::SignatureView& sig = GetTestSignature(sigIndex);
+			std::uniform_int_distribution<size_t> offsetDist(0, buffer.size() - sig.size);
+			for (int i = 0; i < 20; i++)
+			{
+				Plant(buffer, sig, offsetDist(rng), rng);
+			}
+			Plant(buffer, sig, 0, rng);
+			Plant(buffer, sig, buffer.size() - sig.size, rng);
+		}
+
+		for (size_t sigIndex = 0; sigIndex < NUM_TEST_SIGNATURES; sigIndex++)
+		{
+			const Signatures::SignatureView& sig = GetTestSignature(sigIndex);
+			for (size_t startOffset = 0; startOffset < 64; startOffset += 7)
+			{
+				const uint8_t* begin = buffer.data() + startOffset;
+				const uint8_t* end = buffer.data() + buffer.size() - (startOffset % 5);
+
+				const auto expected = ReferenceScan(sig, begin, end);
+				CHECK(!expected.empty());
+				CHECK(MatchesReference(sig, begin, end, expected));
+			}
+		}
+	}
+}
+
+// Signatures replaced hook::pattern strings, so the same string must mean the same bytes
+TEST(Signature_SameBytesAsHookPattern)
+{
+	CHECK(MatchesHookPattern(SIGNATURE("8B 0D ? ? ? ? DF 6C 24 04"), "8B 0D ? ? ? ? DF 6C 24 04"));
+	CHECK(MatchesHookPattern(SIGNATURE("E8 ? ? ? ? 83 F8 04 75 1A"), "E8 ? ? ? ? 83 F8 04 75 1A"));
+	CHECK(MatchesHookPattern(SIGNATURE("dc 0d ? ? ? ? d9 c9"), "dc 0d ? ? ? ? d9 c9"));
+	// Adjacent wildcards are separate bytes, as are adjacent hex pairs
+	CHECK(MatchesHookPattern(SIGNATURE("A1 ?? ?? 85 C0"), "A1 ?? ?? 85 C0"));
+	CHECK(MatchesHookPattern(SIGNATURE("8B0D ? ? ? ?"), "8B0D ? ? ? ?"));
+	CHECK(SIGNATURE("A1 ?? ?? 85 C0").size() == 7);
+}
+
+// hook::pattern returns matches in address order, get_first() being the lowest one,
+// and a wildcard matches every byte value
+TEST(Signature_FirstMatchAndWildcardsLikeHookPattern)
+{
+	constexpr auto sig = SIGNATURE("A1 ? ? 85 C0");
+	std::vector<uint8_t> buffer(1024, 0x90);
+
+	// A match with the rarest byte further in, behind a decoy only matching that byte
+	buffer[100] = 0xA1; buffer[101] = 0x12; buffer[102] = 0x34; buffer[103] = 0x85; buffer[104] = 0xC0;
+	buffer[50] = 0xA1; buffer[53] = 0x85; buffer[54] = 0xC1;
+	buffer[600] = 0xA1; buffer[603] = 0x85; buffer[604] = 0xC0;
+
+	std::vector<const uint8_t*> first;
+	Signatures::Scan(sig.view(), buffer.data(), buffer.data() + buffer.size(), first, 1);
+	CHECK(first.size() == 1 && first[0] == buffer.data() + 100);
+
+	bool allValuesMatch = true;
+	for (int value = 0; value < 256; value++)
+	{
+		buffer[101] = buffer[102] = static_cast<uint8_t>(value);
+		std::vector<const uint8_t*> results;
+		Signatures::Scan(sig.view(), buffer.data(), buffer.data() + buffer.size(), results);
+		allValuesMatch = allValuesMatch && results.size() == 2 && results[0] == buffer.data() + 100 && results[1] == buffer.data() + 600;
+	}
+	CHECK(allValuesMatch);
+}
+
+TEST(Signature_ShortRanges)
+{
+	constexpr auto sig = SIGNATURE("89 43 EC A1");
+	const uint8_t data[] = { 0x89, 0x43, 0xEC, 0xA1, 0x89, 0x43, 0xEC };
+	for (size_t size = 0; size <= std::size(data); size++)
+	{
+		CHECK(MatchesReference(sig.view(), data, data + size, ReferenceScan(sig.view(), data, data + size)));
+	}
+}
+
+TEST(Signature_MaxResults)
+{
+	std::vector<uint8_t> buffer(4096, 0x90);
+	constexpr auto sig = SIGNATURE("BF E8 03 00 00");
+	std::mt19937 rng(1);
+	for (size_t offset = 100; offset < 4000; offset += 500)
+	{
+		Plant(buffer, sig.view(), offset, rng);
+	}
+
+	std::vector<const uint8_t*> results;
+	Signatures::Scan(sig.view(), buffer.data(), buffer.data() + buffer.size(), results, 2);
+	CHECK(results.size() == 2);
+	CHECK(results[0] == buffer.data() + 100);
+	CHECK(results[1] == buffer.data() + 600);
+
+	// Results already in the vector count towards the limit, like when scanning section by section
+	Signatures::Scan(sig.view(), buffer.data(), buffer.data() + buffer.size(), results, 3);
+	CHECK(results.size() == 3);
+}
+
+// Set SIGNATURE_BENCHMARK_DUMP to a raw dump of the game's code section to benchmark on real code,
+// otherwise a synthetic buffer is used
+TEST(Signature_Benchmark)
+{
+	std::vector<uint8_t> buffer;
+	if (const std::string dumpPath = GetDumpPath(); !dumpPath.empty())
+	{
+		std::ifstream file(dumpPath, std::ios::binary);
+		buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	if (buffer.empty())
+	{
+		buffer = MakeCodeLikeBuffer(4 * 1024 * 1024, 42);
+	}
+
+	using Clock = std::chrono::steady_clock;
+	const uint8_t* begin = buffer.data();
+	const uint8_t* end = buffer.data() + buffer.size();
+
+	std::vector<std::vector<const uint8_t*>> referenceResults;
+	auto start = Clock::now();
+	for (size_t i = 0; i < NUM_TEST_SIGNATURES; i++)
+	{
+		referenceResults.push_back(ReferenceScan(GetTestSignature(i), begin, end));
+	}
+	std::printf("  %zu KB, %zu signatures: reference %.2f ms", buffer.size() / 1024, NUM_TEST_SIGNATURES,
+		std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+	const char* const names[] = { "scalar", "SSE2", "AVX2" };
+	for (Signatures::Implementation impl : IMPLEMENTATIONS)
+	{
+		std::vector<std::vector<const uint8_t*>> results(NUM_TEST_SIGNATURES);
+		start = Clock::now();
+		bool available = true;
+		for (size_t i = 0; i < NUM_TEST_SIGNATURES && available; i++)
+		{
+			available = ScanAll(impl, GetTestSignature(i), begin, end, results[i]);
+		}
+		if (available)
+		{
+			std::printf(", %s %.2f ms", names[static_cast<size_t>(impl)], std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+			CHECK(results == referenceResults);
+		}
+	}
+	std::printf("\n");
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal self-registering test cases, so the OS-free parts of the patch can be tested on any platform
+namespace Tests
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*func)();
+		TestCase* next;
+	};
+
+	inline TestCase*& GetFirstTest()
+	{
+		static TestCase* first = nullptr;
+		return first;
+	}
+
+	inline int& GetNumFailures()
+	{
+		static int numFailures = 0;
+		return numFailures;
+	}
+
+	struct Registrar
+	{
+		Registrar(TestCase& test)
+		{
+			test.next = GetFirstTest();
+			GetFirstTest() = &test;
+		}
+	};
+
+	inline void ReportFailure(const char* file, int line, const char* expr)
+	{
+		std::printf("%s(%d): CHECK(%s) failed\n", file, line, expr);
+		GetNumFailures()++;
+	}
+}
+
+#define TEST(name) \
+	static void Test_##name(); \
+	static Tests::TestCase TestCase_##name { #name, &Test_##name, nullptr }; \
+	static Tests::Registrar TestRegistrar_##name(TestCase_##name); \
+	static void Test_##name()
+
+#define CHECK(expr) \
+	do { if (!(expr)) Tests::ReportFailure(__FILE__, __LINE__, #expr); } while (false)
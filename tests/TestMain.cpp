@@ -0,0 +1,37 @@
+// Tests for the OS-free parts of the patch.
+// Besides the premake project, they build on any platform with a C++17 compiler:
+// g++ -std=c++17 -O2 -Wall -Wextra -Isource tests/*.cpp source/Signature.cpp -pthread -lrt -o Tests
+
+#include "TestCommon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	// Registration order is reversed, run the tests in the order they are defined in
+	std::vector<Tests::TestCase*> tests;
+	for (Tests::TestCase* test = Tests::GetFirstTest(); test != nullptr; test = test->next)
+	{
+		tests.push_back(test);
+	}
+	std::reverse(tests.begin(), tests.end());
+
+	// Optional filter on the test name
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int numRun = 0;
+	for (Tests::TestCase* test : tests)
+	{
+		if (filter != nullptr && std::strstr(test->name, filter) == nullptr) continue;
+
+		const int failuresBefore = Tests::GetNumFailures();
+		test->func();
+		std::printf("%s %s\n", Tests::GetNumFailures() == failuresBefore ? "[  OK  ]" : "[FAILED]", test->name);
+		numRun++;
+	}
+
+	std::printf("%d tests run, %d checks failed\n", numRun, Tests::GetNumFailures());
+	return Tests::GetNumFailures() == 0 ? 0 : 1;
+}
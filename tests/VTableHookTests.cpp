@@ -0,0 +1,137 @@
+#include "TestCommon.h"
+
+#include "VTableHook.h"
+
+namespace
+{
+	// Stand-in for a COM interface - an object starting with a pointer to a table of functions taking the object first
+	struct MockSurface
+	{
+		void** vtable;
+		int flips = 0;
+		int blts = 0;
+	};
+
+	using FlipFunc = int (*)(MockSurface* self, int flags);
+	using BltFunc = int (*)(MockSurface* self);
+
+	constexpr size_t VTBL_BLT = 0;
+	constexpr size_t VTBL_FLIP = 1;
+
+	int MockBlt(MockSurface* self)
+	{
+		self->blts++;
+		return 0;
+	}
+
+	int MockFlip(MockSurface* self, int flags)
+	{
+		self->flips++;
+		return flags;
+	}
+
+	int Flip(MockSurface& surface, int flags)
+	{
+		return reinterpret_cast<FlipFunc>(surface.vtable[VTBL_FLIP])(&surface, flags);
+	}
+
+	int Blt(MockSurface& surface)
+	{
+		return reinterpret_cast<BltFunc>(surface.vtable[VTBL_BLT])(&surface);
+	}
+
+	int numWrites;
+	template<typename Write>
+	bool AllowWrite(void*, size_t size, const Write& write)
+	{
+		numWrites++;
+		if (size != sizeof(void*)) return false;
+		write();
+		return true;
+	}
+
+	FlipFunc orgFlip;
+	int numCountedFlips;
+	int Flip_Count(MockSurface* self, int flags)
+	{
+		numCountedFlips++;
+		return orgFlip(self, flags);
+	}
+
+	void Reset(void** vtable)
+	{
+		vtable[VTBL_BLT] = reinterpret_cast<void*>(&MockBlt);
+		vtable[VTBL_FLIP] = reinterpret_cast<void*>(&MockFlip);
+		orgFlip = nullptr;
+		numCountedFlips = 0;
+		numWrites = 0;
+	}
+}
+
+TEST(VTableHook_CallsThroughToOriginal)
+{
+	void* vtable[2];
+	Reset(vtable);
+	MockSurface surface { vtable };
+
+	CHECK(VTableHook::Hook(&surface, VTBL_FLIP, &Flip_Count, orgFlip, [](void* address, size_t size, const auto& write) { return AllowWrite(address, size, write); }));
+	CHECK(orgFlip == &MockFlip);
+	CHECK(VTableHook::IsHooked(&surface, VTBL_FLIP, &Flip_Count));
+
+	CHECK(Flip(surface, 5) == 5);
+	CHECK(numCountedFlips == 1);
+	CHECK(surface.flips == 1);
+
+	// Other slots are left alone
+	Blt(surface);
+	CHECK(surface.blts == 1);
+	CHECK(vtable[VTBL_BLT] == reinterpret_cast<void*>(&MockBlt));
+}
+
+// Surfaces created before the hook went in (like the primary surface and its back buffers) share the vtable
+TEST(VTableHook_CoversExistingObjects)
+{
+	void* vtable[2];
+	Reset(vtable);
+	MockSurface primary { vtable }, backBuffer { vtable };
+
+	VTableHook::Hook(&backBuffer, VTBL_FLIP, &Flip_Count, orgFlip, [](void* address, size_t size, const auto& write) { return AllowWrite(address, size, write); });
+	MockSurface createdLater { vtable };
+
+	Flip(primary, 0);
+	Flip(createdLater, 0);
+	CHECK(numCountedFlips == 2);
+	CHECK(primary.flips == 1 && createdLater.flips == 1);
+}
+
+// Hooking the same slot again, e.g. via another surface, must not make the original point at the hook
+TEST(VTableHook_HookingTwiceIsNoOp)
+{
+	void* vtable[2];
+	Reset(vtable);
+	MockSurface first { vtable }, second { vtable };
+
+	auto allow = [](void* address, size_t size, const auto& write) { return AllowWrite(address, size, write); };
+	VTableHook::Hook(&first, VTBL_FLIP, &Flip_Count, orgFlip, allow);
+	CHECK(VTableHook::Hook(&second, VTBL_FLIP, &Flip_Count, orgFlip, allow));
+	CHECK(numWrites == 1);
+	CHECK(orgFlip == &MockFlip);
+
+	Flip(second, 0);
+	CHECK(numCountedFlips == 1);
+}
+
+TEST(VTableHook_UnwritableSlotIsLeftAlone)
+{
+	void* vtable[2];
+	Reset(vtable);
+	MockSurface surface { vtable };
+
+	CHECK(!VTableHook::Hook(&surface, VTBL_FLIP, &Flip_Count, orgFlip, [](void*, size_t, const auto&) { return false; }));
+	CHECK(orgFlip == nullptr);
+	CHECK(!VTableHook::IsHooked(&surface, VTBL_FLIP, &Flip_Count));
+
+	Flip(surface, 0);
+	CHECK(numCountedFlips == 0);
+	CHECK(surface.flips == 1);
+}
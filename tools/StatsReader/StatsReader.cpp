@@ -0,0 +1,165 @@
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+
+#include <windows.h>
+
+#include "../../source/LiveStats.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cwchar>
+#include <iterator>
+
+#define HAS_FIELD(version, field) LiveStats::HasField(page, version, offsetof(LiveStats::Data, field), sizeof(LiveStats::Data::field))
+
+static constexpr uint32_t MAX_READ_ATTEMPTS = 100000;
+
+// Usage: StatsReader <process ID of the game>
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 2)
+	{
+		fwprintf(stderr, L"Usage: %s <process ID>\n", argv[0]);
+		return 1;
+	}
+
+	const DWORD processID = wcstoul(argv[1], nullptr, 10);
+
+	wchar_t sectionName[64];
+	swprintf_s(sectionName, LiveStats::SECTION_NAME_FORMAT, static_cast<unsigned int>(processID));
+
+	HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, sectionName);
+	if (mapping == nullptr)
+	{
+		fwprintf(stderr, L"Can't open %s - is the game running with LiveStats=1?\n", sectionName);
+		return 1;
+	}
+
+	// The section is as large as the page of the game's version, which may be older or newer than ours
+	const auto* page = static_cast<const LiveStats::Page*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	MEMORY_BASIC_INFORMATION viewInfo;
+	if (page == nullptr || VirtualQuery(page, &viewInfo, sizeof(viewInfo)) == 0 || viewInfo.RegionSize < offsetof(LiveStats::Page, data) ||
+		page->magic != LiveStats::PAGE_MAGIC)
+	{
+		fwprintf(stderr, L"%s is not a stats page\n", sectionName);
+		return 1;
+	}
+	if (!HAS_FIELD(1, configEpoch) || offsetof(LiveStats::Page, data) + page->dataSize > viewInfo.RegionSize)
+	{
+		fwprintf(stderr, L"Unsupported stats page version %u\n", page->version);
+		return 1;
+	}
+
+	// To stop once the game exits
+	HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, processID);
+
+	while (process == nullptr || WaitForSingleObject(process, 0) == WAIT_TIMEOUT)
+	{
+		// The game may stall or die in the middle of an update, so don't wait for it forever
+		LiveStats::Data data;
+		bool read = false;
+		for (uint32_t attempt = 0; attempt < MAX_READ_ATTEMPTS && !read; attempt++)
+		{
+			read = LiveStats::TryRead(page, data);
+			if (!read)
+			{
+				YieldProcessor();
+			}
+		}
+		if (!read)
+		{
+			wprintf(L"Stats page is not being updated\n");
+			Sleep(500);
+			continue;
+		}
+
+		wprintf(L"%6.1f FPS (%6.2f ms) | %ux%u | camera %d | allocs %u/%u | palettes %u | resolutions %u | config #%u\n",
+			data.fps, data.frameTime, data.currentResWidth, data.currentResHeight, data.currentCamera,
+			data.allocListLiveCount, data.allocListCapacity, data.numPalettes, data.numResolutions, data.configEpoch);
+
+		if (HAS_FIELD(2, surfaceMemory))
+		{
+			const auto& mem = data.surfaceMemory;
+			wprintf(L"  surfaces: %u KB video, %u KB system | framebuffers %u KB, depth %u KB, render targets %u KB, textures %u KB (%u), other %u KB | mirror %u\n",
+				mem.videoMemoryBytes / 1024, mem.systemMemoryBytes / 1024, mem.bytesPerCategory[0] / 1024, mem.bytesPerCategory[1] / 1024,
+				mem.bytesPerCategory[2] / 1024, mem.bytesPerCategory[3] / 1024, mem.surfacesPerCategory[3], mem.bytesPerCategory[4] / 1024,
+				mem.mirrorSurfaceSize);
+		}
+
+		if (HAS_FIELD(7, surfaceFormats))
+		{
+			static constexpr const wchar_t* CATEGORY_NAMES[] = { L"framebuffers", L"depth", L"render targets", L"textures", L"other" };
+			wprintf(L"  formats:");
+			for (size_t category = 0; category < std::size(data.surfaceFormats); category++)
+			{
+				const auto& formats = data.surfaceFormats[category];
+				if (formats.formats[0].numSurfaces == 0) continue;
+
+				wprintf(L" | %s", CATEGORY_NAMES[category]);
+				for (const auto& format : formats.formats)
+				{
+					if (format.numSurfaces == 0) break;
+					if (format.fourCC != 0)
+					{
+						const char* fourCC = reinterpret_cast<const char*>(&format.fourCC);
+						wprintf(L" %hc%hc%hc%hc x%u", fourCC[0], fourCC[1], fourCC[2], fourCC[3], format.numSurfaces);
+					}
+					else
+					{
+						wprintf(L" %u-bit x%u", format.bitCount, format.numSurfaces);
+					}
+				}
+				if (formats.numUnlistedSurfaces != 0)
+				{
+					wprintf(L" others x%u", formats.numUnlistedSurfaces);
+				}
+			}
+			wprintf(L"\n");
+		}
+
+		if (HAS_FIELD(3, allocHistogram))
+		{
+			const auto& allocs = data.allocHistogram;
+			wprintf(L"  allocations: %u in %.2f ms |", allocs.numAllocations, allocs.allocationTimeMicroseconds / 1000.0);
+			uint32_t classSize = LiveStats::ALLOC_SMALLEST_SIZE_CLASS;
+			for (uint32_t count : allocs.sizeClassCounts)
+			{
+				if (count != 0)
+				{
+					wprintf(L" <=%u: %u", classSize, count);
+				}
+				classSize *= 2;
+			}
+			wprintf(L"\n");
+		}
+
+		if (HAS_FIELD(4, loadTimes))
+		{
+			const auto& load = data.loadTimes;
+			wprintf(L"  last race load: skins %.2f ms, decals %.2f ms | prefetched %u files, %u KB in %.2f ms\n",
+				load.skinsLoadMicroseconds / 1000.0, load.decalsLoadMicroseconds / 1000.0, load.prefetched,
+				load.prefetchedBytes / 1024, load.prefetchMicroseconds / 1000.0);
+		}
+
+		if (HAS_FIELD(5, directDrawFrame))
+		{
+			const auto& dd = data.directDrawFrame;
+			wprintf(L"  ddraw: %u CreateSurface, %u CreatePalette, %u Lock, %u Unlock, %u Blt, %u Flip | Flip %.2f ms (every %.2f ms), CPU %.2f ms\n",
+				dd.numCreateSurface, dd.numCreatePalette, dd.numLock, dd.numUnlock, dd.numBlt, dd.numFlip,
+				dd.flipMicroseconds / 1000.0, dd.flipIntervalMicroseconds / 1000.0, std::max(0.0, data.frameTime - dd.flipMicroseconds / 1000.0));
+		}
+
+		if (HAS_FIELD(6, restoreAllocations))
+		{
+			const auto& restore = data.restoreAllocations;
+			wprintf(L"  since restore #%u: %u allocations in %.2f ms, list %u/%u\n", restore.numRestores, restore.allocations,
+				restore.allocationTimeMicroseconds / 1000.0, data.allocListLiveCount, data.allocListCapacity);
+		}
+
+		Sleep(500);
+	}
+
+	wprintf(L"The game has exited\n");
+	return 0;
+}